@@ -1,14 +1,43 @@
 ﻿#ifdef _WIN32
 // Otherwise, Visual Studio (2022) complains about scanf.
 #define _CRT_SECURE_NO_WARNINGS 
+#else
+// Exposes clock_gettime() and the POSIX threads under strict C modes.
+#define _DEFAULT_SOURCE
 #endif // _WIN32 
 
+#include <math.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <wchar.h>
 
+#ifdef _WIN32
+// Winsock polls only 64 sockets by default; the solve coordinator
+// polls SOLVER_MAX_CONNECTIONS workers and its listener.
+#define FD_SETSIZE 257
+#include <winsock2.h> // Must come before windows.h.
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif // _WIN32
+
 #define HEIGHT 3 
 #define WIDTH 3
 
@@ -21,6 +50,17 @@
 #define MIN(x,y) (((x) < (y)) ? (x) : (y))
 #define MAX(x,y) (((x) > (y)) ? (x) : (y))
 
+// Define as 0 in order to compile out the search telemetry.
+#ifndef SEARCH_TELEMETRY
+#define SEARCH_TELEMETRY 1
+#endif
+
+#if SEARCH_TELEMETRY
+#define TELEMETRY(statement) statement
+#else
+#define TELEMETRY(statement)
+#endif
+
 static const int POSITIVE_INFINITY = +1000 * 1000 * 1000;
 static const int NEGATIVE_INFINITY = -1000 * 1000 * 1000;
 
@@ -188,17 +228,6 @@ static BoardCellColor board_t_get_cell_color(board_t* board,
     return board->board_data[y * WIDTH + x];
 }
 
-/***********************************************************
-Returns the cell color at position (movement.x, movement.y).
-***********************************************************/
-static BoardCellColor
-board_t_get_cell_color_via_movement(board_t* board, movement_t movement)
-{
-    size_t x = movement.x;
-    size_t y = movement.y;
-    return board_t_get_cell_color(board, x, y);
-}
-
 /*******************************************************************
 Checks whether the movement is valid and it points to an empty cell.
 *******************************************************************/
@@ -355,26 +384,6 @@ static void board_t_make_movement(board_t* board,
     }
 }
 
-/****************
-Copies the board.
-****************/
-static board_t* board_t_copy(board_t* board)
-{
-    board_t* copy = malloc(sizeof(*copy));
-    board_t_init(copy);
-
-    for (size_t y = 0; y < HEIGHT; ++y) {
-        for (size_t x = 0; x < WIDTH; ++x) {
-            board_t_set_cell_color(copy, 
-                                   x, 
-                                   y, 
-                                   board_t_get_cell_color(board, x, y));
-        }
-    }
-
-    return copy;
-}
-
 /*****************************************************************
 Applies the entire board sprite to the board represenation buffer.
 *****************************************************************/
@@ -563,43 +572,6 @@ static WinningStatus board_t_get_winner_status(board_t* board)
     return WIN_NA;
 }
 
-/******************************************
-Runs AI in order to find the next movement.
-******************************************/
-static movement_t compute_next_ai_movement(board_t* board)
-{
-    int best_score = -10000;
-    movement_t best_movement;
-
-    for (size_t y = 0; y < HEIGHT; ++y) {
-        for (size_t x = 0; x < WIDTH; ++x) {
-            movement_t attempted_movement = { y, x };
-
-            if (board_t_can_make_movement(board, attempted_movement)) {
-                board_t* copy = board_t_copy(board);
-
-                board_t_set_cell_color_via_movement(copy,
-                                                    attempted_movement, 
-                                                    CELL_COLOR_O);
-
-                int tentative_score = alpha_beta_pruning(copy, 
-                                                         0, 
-                                                         NEGATIVE_INFINITY, 
-                                                         POSITIVE_INFINITY, 
-                                                         PLAYER_X);
-                board_t_free(copy);
-
-                if (best_score < tentative_score) {
-                    best_score = tentative_score;
-                    best_movement = attempted_movement;
-                }
-            }
-        }
-    }
-
-    return best_movement;
-}
-
 /*********************************************
 Converts player color to the board cell color.
 *********************************************/
@@ -624,245 +596,7780 @@ static bool is_valid_position_character(char ch) {
     return '1' <= ch && ch <= '9';
 }
 
-static size_t millis() {
+/***************************************************************
+Returns the microseconds elapsed since an arbitrary, fixed point
+in time. Unlike the wall clock, this never jumps backwards.
+***************************************************************/
+static uint64_t micros() {
 #ifdef _WIN32
-    return (size_t)GetTickCount();
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+    uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000 + remainder * 1000000 / frequency.QuadPart;
 #else   
-    struct timeval tv;
-    gettimeofday(&v);
-    return (size_t)(tv.sec * 1000 + tv.usec / 1000);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
 #endif
 }
 
-/********************************************
-The implementation of the Alpha-beta pruning.
-********************************************/
-int alpha_beta_pruning(board_t* board,
-                       int depth,
-                       int alpha,
-                       int beta,
-                       PlayerColor player_color)
+static size_t millis() {
+    return (size_t)(micros() / 1000);
+}
+
+/**************************************************
+Returns the number of processors available to us.
+**************************************************/
+static size_t get_number_of_processors()
 {
-    WinningStatus winning_status = board_t_get_winner_status(board);
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return (size_t)system_info.dwNumberOfProcessors;
+#else
+    long number_of_processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return number_of_processors < 1 ? 1 : (size_t)number_of_processors;
+#endif
+}
 
-    if (winning_status == WIN_X) {
-        return -100 + depth;
-    } else if (winning_status == WIN_O) {
-        return 100 - depth;
-    } else if (winning_status == WIN_TIE) {
-        return 0;
-    }
+/**********************************************************
+A thread running 'routine(argument)'. Wraps the native one.
+**********************************************************/
+typedef struct thread_t
+{
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    void (*routine)(void*);
+    void* argument;
+} thread_t;
 
-    if (player_color == PLAYER_O) {
-        int value = NEGATIVE_INFINITY;
-        int best_score = -1000;
-        movement_t best_movement;
-
-        for (size_t y = 0; y < HEIGHT; ++y) {
-            for (size_t x = 0; x < WIDTH; ++x) {
-                movement_t attempted_movement;
-                attempted_movement.y = y;
-                attempted_movement.x = x;
-
-                if (board_t_can_make_movement(board, attempted_movement)) {
-                    BoardCellColor saved_cell_color =
-                        board_t_get_cell_color_via_movement(
-                            board,
-                            attempted_movement);
-
-                    board_t_set_cell_color_via_movement(
-                        board, 
-                        attempted_movement, 
-                        CELL_COLOR_O);
-
-                    int tentative_score = alpha_beta_pruning(board,
-                                                             depth + 1,
-                                                             alpha, 
-                                                             beta,
-                                                             PLAYER_X);
-                    board_t_set_cell_color_via_movement(
-                        board, 
-                        attempted_movement, 
-                        saved_cell_color);
-                    
-                    if (best_score < tentative_score) {
-                        best_score = tentative_score;
-                        best_movement = attempted_movement;
-                    }
+typedef struct mutex_t
+{
+#ifdef _WIN32
+    CRITICAL_SECTION handle;
+#else
+    pthread_mutex_t handle;
+#endif
+} mutex_t;
 
-                    value = MAX(value, tentative_score);
+typedef struct condition_t
+{
+#ifdef _WIN32
+    CONDITION_VARIABLE handle;
+#else
+    pthread_cond_t handle;
+#endif
+} condition_t;
 
-                    if (value >= beta) {
-                        break;
-                    }
+/******************************************************
+Calls the routine of the thread with its own argument.
+******************************************************/
+#ifdef _WIN32
+static DWORD WINAPI thread_t_trampoline(LPVOID thread)
+{
+    ((thread_t*)thread)->routine(((thread_t*)thread)->argument);
+    return 0;
+}
+#else
+static void* thread_t_trampoline(void* thread)
+{
+    ((thread_t*)thread)->routine(((thread_t*)thread)->argument);
+    return NULL;
+}
+#endif
 
-                    alpha = MAX(alpha, value);
-                }
-            }
-        }
+/*****************************************************************
+Starts running 'routine(argument)' in a new thread. Returns false
+if the thread could not be created.
+*****************************************************************/
+static bool thread_t_start(thread_t* thread,
+                           void (*routine)(void*),
+                           void* argument)
+{
+    thread->routine = routine;
+    thread->argument = argument;
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL,
+                                  0,
+                                  thread_t_trampoline,
+                                  thread,
+                                  0,
+                                  NULL);
+    return thread->handle != NULL;
+#else
+    return pthread_create(&thread->handle,
+                          NULL,
+                          thread_t_trampoline,
+                          thread) == 0;
+#endif
+}
 
-        return value + PREFERENCE_FILTER[best_movement.y]
-                                        [best_movement.x];
-
-    } else { // Simulating human player:
-        int value = POSITIVE_INFINITY;
-        int best_score = 1000;
-        movement_t best_movement;
-        
-        for (size_t y = 0; y < HEIGHT; ++y) {
-            for (size_t x = 0; x < WIDTH; ++x) {
-                movement_t attempted_movement;
-                attempted_movement.y = y;
-                attempted_movement.x = x;
-
-                if (board_t_can_make_movement(board, attempted_movement)) {
-                    BoardCellColor saved_cell_color =
-                        board_t_get_cell_color_via_movement(
-                            board, 
-                            attempted_movement);
-
-                    board_t_set_cell_color_via_movement(
-                        board,
-                        attempted_movement, 
-                        CELL_COLOR_X);
-
-                    int tentative_score = alpha_beta_pruning(board,
-                                                             depth + 1,
-                                                             alpha, 
-                                                             beta,  
-                                                             PLAYER_O);
-                    board_t_set_cell_color_via_movement(
-                        board,
-                        attempted_movement,
-                        saved_cell_color);
-
-                    if (best_score > tentative_score) {
-                        best_score = tentative_score;
-                        best_movement = attempted_movement;
-                    }
+/********************************
+Waits for the thread to finish.
+********************************/
+static void thread_t_join(thread_t* thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
 
-                    value = MIN(value, tentative_score);
+static void mutex_t_init(mutex_t* mutex)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_init(&mutex->handle, NULL);
+#endif
+}
 
-                    if (value <= alpha) {
-                        break;
-                    }
+static void mutex_t_lock(mutex_t* mutex)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_lock(&mutex->handle);
+#endif
+}
 
-                    beta = MIN(beta, value);
-                }
-            }
-        }
+static void mutex_t_unlock(mutex_t* mutex)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_unlock(&mutex->handle);
+#endif
+}
+
+static void mutex_t_free(mutex_t* mutex)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_destroy(&mutex->handle);
+#endif
+}
+
+static void condition_t_init(condition_t* condition)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(&condition->handle);
+#else
+    pthread_cond_init(&condition->handle, NULL);
+#endif
+}
+
+/************************************************************
+Releases 'mutex', waits for a signal and reacquires 'mutex'.
+************************************************************/
+static void condition_t_wait(condition_t* condition, mutex_t* mutex)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(&condition->handle, &mutex->handle, INFINITE);
+#else
+    pthread_cond_wait(&condition->handle, &mutex->handle);
+#endif
+}
+
+static void condition_t_broadcast(condition_t* condition)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(&condition->handle);
+#else
+    pthread_cond_broadcast(&condition->handle);
+#endif
+}
+
+static void condition_t_free(condition_t* condition)
+{
+#ifndef _WIN32
+    pthread_cond_destroy(&condition->handle);
+#else
+    (void)condition; // Windows condition variables need no cleanup.
+#endif
+}
+
+#ifndef _WIN32
+#define PATH_CAPACITY 4096
+
+/************************************************************
+Converts the wide 'path' to the multibyte 'narrow_path'.
+Returns false if the path does not fit.
+************************************************************/
+static bool narrow_down_path(const wchar_t* path,
+                             char narrow_path[PATH_CAPACITY])
+{
+    size_t length = wcstombs(narrow_path, path, PATH_CAPACITY);
+    return length != (size_t)-1 && length < PATH_CAPACITY;
+}
+#endif // _WIN32
 
-        return value - PREFERENCE_FILTER[best_movement.y]
-                                        [best_movement.x];
+/*************************************************************
+Opens the file at the wide 'path' with the (narrow) 'mode'.
+*************************************************************/
+static FILE* open_file(const wchar_t* path, const char* mode)
+{
+#ifdef _WIN32
+    wchar_t wide_mode[8];
+    mbstowcs(wide_mode, mode, sizeof(wide_mode) / sizeof(wide_mode[0]));
+    return _wfopen(path, wide_mode);
+#else
+    char narrow_path[PATH_CAPACITY];
+
+    if (!narrow_down_path(path, narrow_path)) {
+        return NULL;
     }
+
+    return fopen(narrow_path, mode);
+#endif
 }
 
-/*******************************
-Generates a random player color.
-*******************************/
-static PlayerColor generate_random_player_color()
+/*******************************************************************
+A TCP socket: a SOCKET on Windows, a file descriptor elsewhere.
+*******************************************************************/
+#ifdef _WIN32
+typedef SOCKET socket_t;
+#else
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#endif
+
+/*******************************************************************
+Prepares the process for using sockets. Elsewhere than on Windows, a
+peer going away must show up as a failed send, not as SIGPIPE.
+*******************************************************************/
+static bool sockets_init()
 {
-    return rand() % 2 == 0 ? PLAYER_X : PLAYER_O;
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
 }
 
-/**************************
-Runs a match against a bot.
-**************************/
-void bot_mode()
+static void sockets_free()
 {
-    board_t board;
-    board_t_init(&board);
-    board_t_set_initial_cell_values(&board);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
 
-    bool gameInProgress = true;
-    PlayerColor player_color = generate_random_player_color();
+static void socket_t_close(socket_t handle)
+{
+#ifdef _WIN32
+    closesocket(handle);
+#else
+    close(handle);
+#endif
+}
 
-    puts("Your mark is X, AI is O.");
-    board_t_print(&board);
+/*******************************************************************
+Sends the small messages of the solver right away instead of
+coalescing them.
+*******************************************************************/
+static void socket_t_set_no_delay(socket_t handle)
+{
+    int no_delay = 1;
+    setsockopt(handle, 
+               IPPROTO_TCP, 
+               TCP_NODELAY, 
+               (const char*)&no_delay, 
+               sizeof(no_delay));
+}
 
-    while (true) {
-        if (player_color == PLAYER_X) {
-            puts(">>> It's your turn.");
-        } else {
-            puts(">>> AI's turn.");
+/*******************************************************************
+Listens on 'address' at '*port', 0 picking any free port, and stores
+the port actually listened on to '*port'. Returns INVALID_SOCKET if
+the address cannot be listened on.
+*******************************************************************/
+static socket_t socket_t_listen(const char* address, uint16_t* port)
+{
+    struct addrinfo hints = { 0 };
+    struct addrinfo* addresses;
+    socket_t listener = INVALID_SOCKET;
+    char service[8];
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    snprintf(service, sizeof(service), "%u", (unsigned)*port);
+
+    if (getaddrinfo(address, service, &hints, &addresses) != 0) {
+        return INVALID_SOCKET;
+    }
+
+    for (struct addrinfo* a = addresses; a != NULL; a = a->ai_next) {
+        int reuse = 1;
+        listener = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+
+        if (listener == INVALID_SOCKET) {
+            continue;
         }
 
-        if (player_color == PLAYER_X) {
-            movement_t desired_movement;
-            desired_movement.x = WIDTH;
-            desired_movement.y = HEIGHT;
+        setsockopt(listener, 
+                   SOL_SOCKET, 
+                   SO_REUSEADDR, 
+                   (const char*)&reuse, 
+                   sizeof(reuse));
 
-            do
-            {
-                printf("Please enter your desired move: ");
+        if (bind(listener, a->ai_addr, (int)a->ai_addrlen) == 0 &&
+            listen(listener, SOMAXCONN) == 0) {
+            break;
+        }
 
-                fflush(stdin);
+        socket_t_close(listener);
+        listener = INVALID_SOCKET;
+    }
 
-                char position_choice;
+    freeaddrinfo(addresses);
 
-                scanf("%c", &position_choice);
+    if (listener != INVALID_SOCKET) {
+        struct sockaddr_storage bound;
+        socklen_t length = sizeof(bound);
 
-                if (!is_valid_position_character(position_choice)) {
-                    puts("");
-                    continue;
-                }
+        getsockname(listener, (struct sockaddr*)&bound, &length);
+        *port = ntohs(bound.ss_family == AF_INET6 
+            ? ((struct sockaddr_in6*)&bound)->sin6_port
+            : ((struct sockaddr_in*)&bound)->sin_port);
+    }
 
-                desired_movement = 
-                    convert_board_selector_to_move(position_choice);
+    return listener;
+}
 
-            } while (!board_t_can_make_movement(&board, desired_movement));
+/*******************************************************************
+Connects to 'host' at 'service' (a port number). Returns 
+INVALID_SOCKET if no address of the host accepts the connection.
+*******************************************************************/
+static socket_t socket_t_connect(const char* host, const char* service)
+{
+    struct addrinfo hints = { 0 };
+    struct addrinfo* addresses;
+    socket_t connection = INVALID_SOCKET;
 
-            board_t_set_cell_color_via_movement(
-                &board, 
-                desired_movement,
-                player_color_to_board_cell_color(player_color));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
 
-        } else {
-            // This belongs to the AI.
-            size_t duration = millis();
-            movement_t best_movement = compute_next_ai_movement(&board);
-            duration = millis() - duration;
+    if (getaddrinfo(host, service, &hints, &addresses) != 0) {
+        return INVALID_SOCKET;
+    }
 
-            printf("AI duration: %zu milliseconds.\n", duration);
+    for (struct addrinfo* a = addresses; a != NULL; a = a->ai_next) {
+        connection = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
 
-            board_t_set_cell_color_via_movement(
-                &board,
-                best_movement,
-                player_color_to_board_cell_color(player_color));
+        if (connection == INVALID_SOCKET) {
+            continue;
         }
 
-        board_t_print(&board);
+        if (connect(connection, a->ai_addr, (int)a->ai_addrlen) == 0) {
+            socket_t_set_no_delay(connection);
+            break;
+        }
 
-        WinningStatus winning_status = board_t_get_winner_status(&board);
+        socket_t_close(connection);
+        connection = INVALID_SOCKET;
+    }
 
-        if (winning_status == WIN_X) {
-            puts("You won!");
-            gameInProgress = false;
-        } else if (winning_status == WIN_O) {
-            puts("AI won.");
-            gameInProgress = false;
-        } else if (winning_status == WIN_TIE) {
-            puts("It's a tie.");
-            gameInProgress = false;
-        }
+    freeaddrinfo(addresses);
+    return connection;
+}
 
-        if (gameInProgress == false) {
-            puts("");
-            return;
+static bool socket_t_send_all(socket_t handle, const char* data, size_t size)
+{
+    while (size > 0) {
+        int sent = (int)send(handle, data, (int)size, 0);
+
+        if (sent <= 0) {
+            return false;
         }
 
-        // Invert the player
-        player_color = invert_player_color(player_color);
+        data += sent;
+        size -= (size_t)sent;
     }
+
+    return true;
 }
 
-int wmain(int argc, wchar_t* argv[])
+#define SOCKET_LINE_CAPACITY 1024
+
+/*******************************************************************
+Splits what is received from a socket into lines.
+*******************************************************************/
+typedef struct line_reader_t
 {
-    // v
-    // v
-    // v For random choice whether X or O makes the first move.
-    srand(time(NULL)); 
-    load_all_sprites();
-    bot_mode();
-    return 0;
+    socket_t handle;
+    char buffer[SOCKET_LINE_CAPACITY];
+    size_t length;
+} line_reader_t;
+
+static void line_reader_t_init(line_reader_t* reader, socket_t handle)
+{
+    reader->handle = handle;
+    reader->length = 0;
+}
+
+/*******************************************************************
+Receives what is available, blocking while nothing is. Returns false
+if the peer closed the connection, the connection failed or the peer
+sent a line longer than SOCKET_LINE_CAPACITY.
+*******************************************************************/
+static bool line_reader_t_receive(line_reader_t* reader)
+{
+    if (reader->length == SOCKET_LINE_CAPACITY) {
+        return false;
+    }
+
+    int received = (int)recv(reader->handle, 
+                             reader->buffer + reader->length, 
+                             (int)(SOCKET_LINE_CAPACITY - reader->length), 
+                             0);
+    if (received <= 0) {
+        return false;
+    }
+
+    reader->length += (size_t)received;
+    return true;
+}
+
+/*******************************************************************
+Moves the next complete line, without its newline, to 'line'. 
+Returns false if no complete line has been received yet.
+*******************************************************************/
+static bool line_reader_t_next_line(line_reader_t* reader,
+                                    char line[SOCKET_LINE_CAPACITY])
+{
+    char* end = memchr(reader->buffer, '\n', reader->length);
+
+    if (end == NULL) {
+        return false;
+    }
+
+    size_t length = (size_t)(end - reader->buffer);
+    memcpy(line, reader->buffer, length);
+    line[length] = '\0';
+    reader->length -= length + 1;
+    memmove(reader->buffer, end + 1, reader->length);
+    return true;
+}
+
+/*******************************************************************
+Blocks until the next complete line arrives. Returns false if the
+connection ends first.
+*******************************************************************/
+static bool line_reader_t_read_line(line_reader_t* reader,
+                                    char line[SOCKET_LINE_CAPACITY])
+{
+    while (!line_reader_t_next_line(reader, line)) {
+        if (!line_reader_t_receive(reader)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*********************************************
+A child process running this very program.
+*********************************************/
+typedef struct process_t
+{
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pid_t handle;
+#endif
+    bool exited;
+} process_t;
+
+/*******************************************************************
+Starts this program again with the NULL-terminated 'arguments', the
+first one being the name of the program. Returns false if the
+process could not be started.
+*******************************************************************/
+static bool process_t_start(process_t* process, char* const arguments[])
+{
+    process->exited = false;
+#ifdef _WIN32
+    wchar_t path[MAX_PATH];
+    wchar_t command_line[1024];
+    STARTUPINFOW startup_info = { sizeof(startup_info) };
+    PROCESS_INFORMATION information;
+
+    if (GetModuleFileNameW(NULL, path, MAX_PATH) == MAX_PATH) {
+        return false;
+    }
+
+    int length = swprintf(command_line, 1024, L"\"%ls\"", path);
+
+    for (size_t i = 1; arguments[i] != NULL && length >= 0; ++i) {
+        int appended = swprintf(command_line + length,
+                                1024 - (size_t)length, 
+                                L" %hs", 
+                                arguments[i]);
+        length = appended < 0 ? -1 : length + appended;
+    }
+
+    if (length < 0 ||
+        !CreateProcessW(path, 
+                        command_line, 
+                        NULL, 
+                        NULL, 
+                        FALSE, 
+                        0, 
+                        NULL, 
+                        NULL, 
+                        &startup_info, 
+                        &information)) {
+        return false;
+    }
+
+    CloseHandle(information.hThread);
+    process->handle = information.hProcess;
+    return true;
+#else
+    process->handle = fork();
+
+    if (process->handle == 0) {
+        // Only the standard streams are meant for the child. The
+        // sockets of the coordinator stay below FD_SETSIZE for select().
+        for (int fd = STDERR_FILENO + 1; fd < FD_SETSIZE; ++fd) {
+            close(fd);
+        }
+
+        execv("/proc/self/exe", arguments);
+        execvp(arguments[0], arguments);
+        _exit(127);
+    }
+
+    return process->handle > 0;
+#endif
+}
+
+/*******************************************************************
+Returns true if the process has exited, without waiting for it.
+*******************************************************************/
+static bool process_t_has_exited(process_t* process)
+{
+    if (!process->exited) {
+#ifdef _WIN32
+        process->exited = 
+            WaitForSingleObject(process->handle, 0) == WAIT_OBJECT_0;
+#else
+        process->exited = 
+            waitpid(process->handle, NULL, WNOHANG) == process->handle;
+#endif
+    }
+
+    return process->exited;
+}
+
+/*****************************************************
+Waits for the process to exit and releases its handle.
+*****************************************************/
+static void process_t_join(process_t* process)
+{
+#ifdef _WIN32
+    WaitForSingleObject(process->handle, INFINITE);
+    CloseHandle(process->handle);
+#else
+    if (!process->exited) {
+        waitpid(process->handle, NULL, 0);
+    }
+#endif
+    process->exited = true;
+}
+
+/*******************************************************************
+Writes Chrome trace events ("chrome://tracing", Perfetto) to a file.
+Events are complete ("X") events on the thread 'thread_id' of a
+single process; several threads may add events at the same time.
+*******************************************************************/
+typedef struct trace_writer_t
+{
+    FILE* file;
+    mutex_t mutex;
+    uint64_t origin; // micros() when the trace was opened.
+    bool has_events;
+} trace_writer_t;
+
+#if SEARCH_TELEMETRY
+static bool trace_writer_t_open(trace_writer_t* trace_writer,
+                                const wchar_t* path)
+{
+    trace_writer->file = open_file(path, "w");
+
+    if (trace_writer->file == NULL) {
+        return false;
+    }
+
+    mutex_t_init(&trace_writer->mutex);
+    trace_writer->origin = micros();
+    trace_writer->has_events = false;
+    fputs("[\n", trace_writer->file);
+    return true;
+}
+
+/**********************************************************
+Records that the thread 'thread_id' spent the microseconds
+from 'start' to 'end' (as returned by micros()) in 'name'.
+**********************************************************/
+static void trace_writer_t_add_event(trace_writer_t* trace_writer,
+                                     const char* name,
+                                     size_t thread_id,
+                                     uint64_t start,
+                                     uint64_t end)
+{
+    mutex_t_lock(&trace_writer->mutex);
+    fprintf(trace_writer->file,
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,"
+            "\"ts\":%llu,\"dur\":%llu}",
+            trace_writer->has_events ? ",\n" : "",
+            name,
+            thread_id,
+            (unsigned long long)(start - trace_writer->origin),
+            (unsigned long long)(end - start));
+    trace_writer->has_events = true;
+    mutex_t_unlock(&trace_writer->mutex);
+}
+
+/***********************************************
+Labels the thread 'thread_id' in the trace view.
+***********************************************/
+static void trace_writer_t_name_thread(trace_writer_t* trace_writer,
+                                       size_t thread_id,
+                                       const char* name)
+{
+    mutex_t_lock(&trace_writer->mutex);
+    fprintf(trace_writer->file,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+            trace_writer->has_events ? ",\n" : "",
+            thread_id,
+            name);
+    trace_writer->has_events = true;
+    mutex_t_unlock(&trace_writer->mutex);
+}
+
+static bool trace_writer_t_close(trace_writer_t* trace_writer)
+{
+    fputs("\n]\n", trace_writer->file);
+    mutex_t_free(&trace_writer->mutex);
+    return fclose(trace_writer->file) == 0;
+}
+#endif // SEARCH_TELEMETRY
+
+#define TELEMETRY_MAX_DEPTH 32
+#define TELEMETRY_MAX_MOVES 81
+#define TELEMETRY_MAX_ITERATIONS 64
+
+/*******************************************************************
+What a single search did. The transposition table counters and the
+per-iteration times stay zero for the searches that have no table or
+no iterative deepening.
+*******************************************************************/
+typedef struct search_telemetry_t
+{
+    uint64_t nodes_per_depth[TELEMETRY_MAX_DEPTH];
+    
+    // cutoffs_per_index[i] counts the beta cutoffs caused by the
+    // (i + 1)th movement tried in a node.
+    uint64_t cutoffs_per_index[TELEMETRY_MAX_MOVES];
+    uint64_t table_probes;
+    uint64_t table_hits;
+    uint64_t table_collisions; // Probes finding another position.
+    size_t number_of_iterations;
+    uint64_t iteration_micros[TELEMETRY_MAX_ITERATIONS];
+} search_telemetry_t;
+
+/*****************************************************
+Holds the state threaded through a single AI search.
+*****************************************************/
+typedef struct search_context_t
+{
+    size_t nodes; // Number of positions visited by the search.
+#if SEARCH_TELEMETRY
+    search_telemetry_t telemetry;
+    trace_writer_t* trace_writer; // NULL unless tracing.
+    size_t thread_id;             // The thread in the trace.
+#endif
+} search_context_t;
+
+#if SEARCH_TELEMETRY
+/*******************************************************************
+Returns the effective branching factor: the branching factor of the
+uniform tree with as many levels and leaves as the searched one had
+nodes, i.e. the 'levels'th root of the node count.
+*******************************************************************/
+static double search_telemetry_t_branching_factor(
+    const search_telemetry_t* telemetry)
+{
+    uint64_t nodes = 0;
+    size_t levels = 0;
+
+    for (size_t depth = 0; depth < TELEMETRY_MAX_DEPTH; ++depth) {
+        if (telemetry->nodes_per_depth[depth] > 0) {
+            nodes += telemetry->nodes_per_depth[depth];
+            levels = depth + 1;
+        }
+    }
+
+    if (levels == 0) {
+        return 0.0;
+    }
+
+    return pow((double)nodes, 1.0 / (double)levels);
+}
+
+/*****************************************************
+Writes 'count' counters as a JSON array, dropping the
+trailing zeros.
+*****************************************************/
+static void write_json_counters(FILE* file,
+                                const uint64_t* counters,
+                                size_t count)
+{
+    while (count > 0 && counters[count - 1] == 0) {
+        count--;
+    }
+
+    fputc('[', file);
+
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(file, 
+                "%s%llu", 
+                i == 0 ? "" : ",", 
+                (unsigned long long)counters[i]);
+    }
+
+    fputc(']', file);
+}
+
+/*******************************************************************
+Writes the telemetry of the search for the move number 'ply' as a
+single line of JSON. 'cell' is the chosen cell counting from 1 and
+'micros' the duration of the search.
+*******************************************************************/
+static void search_context_t_write_telemetry(const search_context_t* context,
+                                             FILE* file,
+                                             size_t ply,
+                                             PlayerColor player_color,
+                                             size_t cell,
+                                             int score,
+                                             uint64_t micros)
+{
+    const search_telemetry_t* telemetry = &context->telemetry;
+
+    fprintf(file,
+            "{\"ply\":%zu,\"player\":\"%c\",\"move\":%zu,\"score\":%d,"
+            "\"micros\":%llu,\"nodes\":%zu,\"nps\":%.0f,\"ebf\":%.3f,"
+            "\"nodes_per_depth\":",
+            ply,
+            player_color == PLAYER_X ? 'X' : 'O',
+            cell,
+            score,
+            (unsigned long long)micros,
+            context->nodes,
+            micros == 0 ? 0.0 : context->nodes * 1e6 / (double)micros,
+            search_telemetry_t_branching_factor(telemetry));
+    write_json_counters(file, 
+                        telemetry->nodes_per_depth, 
+                        TELEMETRY_MAX_DEPTH);
+    fputs(",\"cutoffs_per_index\":", file);
+    write_json_counters(file, 
+                        telemetry->cutoffs_per_index, 
+                        TELEMETRY_MAX_MOVES);
+    fprintf(file,
+            ",\"table\":{\"probes\":%llu,\"hits\":%llu,\"collisions\":%llu}"
+            ",\"iteration_micros\":",
+            (unsigned long long)telemetry->table_probes,
+            (unsigned long long)telemetry->table_hits,
+            (unsigned long long)telemetry->table_collisions);
+    write_json_counters(file, 
+                        telemetry->iteration_micros, 
+                        telemetry->number_of_iterations);
+    fputs("}\n", file);
+}
+
+/*****************************************************************
+Records a search phase of the context's thread in the trace, if
+the search is traced.
+*****************************************************************/
+static void search_context_t_trace(search_context_t* context,
+                                   const char* name,
+                                   uint64_t start)
+{
+    if (context->trace_writer != NULL) {
+        trace_writer_t_add_event(context->trace_writer,
+                                 name,
+                                 context->thread_id,
+                                 start,
+                                 micros());
+    }
+}
+#endif // SEARCH_TELEMETRY
+
+/*******************************************************************
+The knobs of the AI engines, so that tournaments can pit different
+settings against each other. The zero members stand for the defaults
+of the variant.
+*******************************************************************/
+typedef struct engine_settings_t
+{
+    uint32_t time_budget;       // Milliseconds per move.
+    uint32_t max_depth;         // The deepest iteration.
+    uint32_t table_bits;        // 2^table_bits table entries.
+    bool no_history;            // Turns off the history heuristic.
+    bool has_preference_filter; // Replaces the 3x3 PREFERENCE_FILTER.
+    int preference_filter[HEIGHT][WIDTH];
+} engine_settings_t;
+
+// The engine settings a variant honors.
+#define ENGINE_SETTING_TIME        0x01
+#define ENGINE_SETTING_DEPTH       0x02
+#define ENGINE_SETTING_TABLE       0x04
+#define ENGINE_SETTING_HISTORY     0x08
+#define ENGINE_SETTING_PREFERENCES 0x10
+
+typedef enum TableBound
+{
+    BOUND_NONE,  // The table entry is empty.
+    BOUND_EXACT, // The score is exact.
+    BOUND_LOWER, // The score failed high: the real one is not lower.
+    BOUND_UPPER, // The score failed low: the real one is not higher.
+} TableBound;
+
+#define ROOT_ANALYSIS_CELLS (WIDTH * HEIGHT)
+#define ROOT_ANALYSIS_WIN_SCORE 100
+#define ROOT_ANALYSIS_INFINITY 1000
+#define ROOT_ANALYSIS_TABLE_SIZE (2 * 19683) // Side to move times 3^9.
+
+/*****************************************************************
+The winning lines of the 3x3 board; the cell (x, y) is the bit
+y * WIDTH + x.
+*****************************************************************/
+static const uint16_t ROOT_ANALYSIS_LINES[8] = {
+    0x007, 0x038, 0x1c0, // Rows.
+    0x049, 0x092, 0x124, // Columns.
+    0x111, 0x054,        // Diagonals.
+};
+
+static const uint16_t ROOT_ANALYSIS_POWERS_OF_3[ROOT_ANALYSIS_CELLS] = {
+    1, 3, 9, 27, 81, 243, 729, 2187, 6561,
+};
+
+/*******************************************************************
+A ranked movement of the root analysis. The score is exact: positive
+scores favor O, negative ones favor X, and a win 'n' movements away,
+counting both players, scores 101 - n. The principal variation
+starts with the movement itself and lists cells (y * WIDTH + x).
+*******************************************************************/
+typedef struct root_line_t
+{
+    movement_t movement;
+    int score;
+    size_t pv_length;
+    uint8_t pv[ROOT_ANALYSIS_CELLS];
+} root_line_t;
+
+typedef struct root_table_entry_t
+{
+    int8_t score;     // Relative to the position, see below.
+    uint8_t bound;    // TableBound.
+    uint8_t movement; // The best cell found.
+} root_table_entry_t;
+
+/*******************************************************************
+The state shared by all the root movements of one analysis: a table
+indexed by the position itself, as the 3x3 board has only 3^9 of
+them, and the cells in the order of the preference filter.
+*******************************************************************/
+typedef struct root_analysis_t
+{
+    root_table_entry_t table[ROOT_ANALYSIS_TABLE_SIZE];
+    uint8_t order[ROOT_ANALYSIS_CELLS];
+    search_context_t* context;
+} root_analysis_t;
+
+static bool root_analysis_has_line(uint16_t marks)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        if ((marks & ROOT_ANALYSIS_LINES[i]) == ROOT_ANALYSIS_LINES[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************
+Win scores count from the root; the table keeps them counted from
+the position so that they hold wherever the position is reached.
+*******************************************************************/
+static int root_score_to_table(int score, int ply)
+{
+    return score > 0 ? score + ply : score < 0 ? score - ply : 0;
+}
+
+static int root_score_from_table(int score, int ply)
+{
+    return score > 0 ? score - ply : score < 0 ? score + ply : 0;
+}
+
+/*******************************************************************
+The negamax alpha-beta search of the position where 'own' marks the
+cells of 'player_color', to move 'ply' movements from the root, and
+'opponent' those of the other player. 'key' is the base-3 number of
+the position. Returns the score from the point of view of the mover.
+*******************************************************************/
+static int root_analysis_t_search(root_analysis_t* analysis,
+                                  uint16_t own,
+                                  uint16_t opponent,
+                                  size_t key,
+                                  PlayerColor player_color,
+                                  int ply,
+                                  int alpha,
+                                  int beta)
+{
+    search_context_t* context = analysis->context;
+
+    context->nodes++;
+    TELEMETRY(context->telemetry.nodes_per_depth[
+                  MIN(ply, TELEMETRY_MAX_DEPTH - 1)]++);
+
+    if (root_analysis_has_line(opponent)) {
+        return ply - (ROOT_ANALYSIS_WIN_SCORE + 1);
+    }
+
+    if ((own | opponent) == (1 << ROOT_ANALYSIS_CELLS) - 1) {
+        return 0;
+    }
+
+    root_table_entry_t* entry = 
+        &analysis->table[key * 2 + (size_t)player_color];
+    int table_movement = -1;
+
+    TELEMETRY(context->telemetry.table_probes++);
+
+    if (entry->bound != BOUND_NONE) {
+        int score = root_score_from_table(entry->score, ply);
+        TELEMETRY(context->telemetry.table_hits++);
+
+        if (entry->bound == BOUND_EXACT ||
+            (entry->bound == BOUND_LOWER && score >= beta) ||
+            (entry->bound == BOUND_UPPER && score <= alpha)) {
+            return score;
+        }
+
+        table_movement = entry->movement;
+    }
+
+    size_t mark = player_color == PLAYER_X ? 1 : 2;
+    int original_alpha = alpha;
+    int best_score = -ROOT_ANALYSIS_INFINITY;
+    uint8_t best_movement = 0;
+    TELEMETRY(size_t movement_index = 0);
+
+    // The table movement first, then the rest by the preferences.
+    for (int i = -1; i < ROOT_ANALYSIS_CELLS; ++i) {
+        int cell = i < 0 ? table_movement : analysis->order[i];
+
+        if (cell < 0 || 
+            (i >= 0 && cell == table_movement) ||
+            ((own | opponent) & (1 << cell)) != 0) {
+            continue;
+        }
+
+        int score = -root_analysis_t_search(
+            analysis,
+            opponent,
+            (uint16_t)(own | 1 << cell),
+            key + mark * ROOT_ANALYSIS_POWERS_OF_3[cell],
+            invert_player_color(player_color),
+            ply + 1,
+            -beta,
+            -alpha);
+
+        if (score > best_score) {
+            best_score = score;
+            best_movement = (uint8_t)cell;
+        }
+
+        alpha = MAX(alpha, score);
+
+        if (alpha >= beta) {
+            TELEMETRY(context->telemetry.cutoffs_per_index[
+                          movement_index]++);
+            break;
+        }
+
+        TELEMETRY(movement_index++);
+    }
+
+    entry->score = (int8_t)root_score_to_table(best_score, ply);
+    entry->movement = best_movement;
+    entry->bound = best_score <= original_alpha ? BOUND_UPPER :
+                   best_score >= beta ? BOUND_LOWER : BOUND_EXACT;
+    return best_score;
+}
+
+/*******************************************************************
+Follows the principal variation of the position scored 'score' from
+the point of view of the mover, storing its cells to 'pv'. Scores
+count from the root, so the score stays the same along the variation
+up to the sign; null window searches, mostly answered by the table,
+find the movements keeping it. Returns the length of the variation.
+*******************************************************************/
+static size_t root_analysis_t_get_pv(root_analysis_t* analysis,
+                                     uint16_t own,
+                                     uint16_t opponent,
+                                     size_t key,
+                                     PlayerColor player_color,
+                                     int ply,
+                                     int score,
+                                     uint8_t* pv)
+{
+    size_t length = 0;
+
+    while (!root_analysis_has_line(opponent) &&
+           (own | opponent) != (1 << ROOT_ANALYSIS_CELLS) - 1) {
+        size_t mark = player_color == PLAYER_X ? 1 : 2;
+        int next_cell = -1;
+
+        for (size_t i = 0; i < ROOT_ANALYSIS_CELLS && next_cell < 0; ++i) {
+            int cell = analysis->order[i];
+
+            if (((own | opponent) & (1 << cell)) == 0 &&
+                -root_analysis_t_search(
+                    analysis,
+                    opponent,
+                    (uint16_t)(own | 1 << cell),
+                    key + mark * ROOT_ANALYSIS_POWERS_OF_3[cell],
+                    invert_player_color(player_color),
+                    ply + 1,
+                    -score - 1,
+                    -score + 1) == score) {
+                next_cell = cell;
+            }
+        }
+
+        if (next_cell < 0) {
+            break;
+        }
+
+        uint16_t marks = (uint16_t)(own | 1 << next_cell);
+        pv[length++] = (uint8_t)next_cell;
+        key += mark * ROOT_ANALYSIS_POWERS_OF_3[next_cell];
+        own = opponent;
+        opponent = marks;
+        player_color = invert_player_color(player_color);
+        ply++;
+        score = -score;
+    }
+
+    return length;
+}
+
+/*******************************************************************
+Ranks the movements 'player_color' can make on the board by a single
+search: the movements share the table, and once 'number_of_lines'
+movements are scored, the rest are searched only to see whether
+they beat the worst of them. Stores the best 'number_of_lines'
+movements, best first, to 'lines' with their exact scores and
+principal variations; equal scores go by 'preference_filter'.
+Returns the number of the lines, 0 if the game is over.
+*******************************************************************/
+static size_t analyze_root_movements(board_t* board,
+                                     PlayerColor player_color,
+                                     const int preference_filter[HEIGHT]
+                                                                [WIDTH],
+                                     size_t number_of_lines,
+                                     root_line_t* lines,
+                                     search_context_t* context)
+{
+    root_analysis_t* analysis = malloc(sizeof(*analysis));
+    int scores[ROOT_ANALYSIS_CELLS]; // From the point of view of the mover.
+    uint16_t marks[2] = { 0, 0 };
+    size_t key = 0;
+    size_t count = 0;
+
+    if (analysis == NULL || number_of_lines == 0) {
+        free(analysis);
+        return 0;
+    }
+
+    memset(analysis->table, 0, sizeof(analysis->table));
+    analysis->context = context;
+
+    for (size_t cell = 0; cell < ROOT_ANALYSIS_CELLS; ++cell) {
+        BoardCellColor color = board->board_data[cell];
+        size_t i = cell;
+
+        // Insertion sort by the preferences, keeping the cell order
+        // among equals.
+        while (i > 0 && 
+               preference_filter[analysis->order[i - 1] / WIDTH]
+                                [analysis->order[i - 1] % WIDTH] <
+               preference_filter[cell / WIDTH][cell % WIDTH]) {
+            analysis->order[i] = analysis->order[i - 1];
+            i--;
+        }
+
+        analysis->order[i] = (uint8_t)cell;
+
+        if (color == CELL_COLOR_X || color == CELL_COLOR_O) {
+            size_t mark = color == CELL_COLOR_X ? 1 : 2;
+            marks[mark - 1] |= (uint16_t)(1 << cell);
+            key += mark * ROOT_ANALYSIS_POWERS_OF_3[cell];
+        }
+    }
+
+    uint16_t own = marks[player_color];
+    uint16_t opponent = marks[invert_player_color(player_color)];
+    size_t mark = player_color == PLAYER_X ? 1 : 2;
+
+    if (root_analysis_has_line(own) || root_analysis_has_line(opponent)) {
+        free(analysis);
+        return 0;
+    }
+
+    for (size_t i = 0; i < ROOT_ANALYSIS_CELLS; ++i) {
+        size_t cell = analysis->order[i];
+
+        if (((own | opponent) & (1 << cell)) != 0) {
+            continue;
+        }
+
+        TELEMETRY(uint64_t root_movement_start = micros());
+        int alpha = count < number_of_lines ? -ROOT_ANALYSIS_INFINITY 
+                                            : scores[count - 1];
+        int score = -root_analysis_t_search(
+            analysis,
+            opponent,
+            (uint16_t)(own | 1 << cell),
+            key + mark * ROOT_ANALYSIS_POWERS_OF_3[cell],
+            invert_player_color(player_color),
+            1,
+            -ROOT_ANALYSIS_INFINITY,
+            -alpha);
+
+        TELEMETRY(search_context_t_trace(context,
+                                         "root movement",
+                                         root_movement_start));
+
+        if (score <= alpha) {
+            continue; // Not among the lines; the score is a bound.
+        }
+
+        size_t j = MIN(count, number_of_lines - 1);
+        count = MIN(count + 1, number_of_lines);
+
+        for (; j > 0 && scores[j - 1] < score; --j) {
+            scores[j] = scores[j - 1];
+            lines[j] = lines[j - 1];
+        }
+
+        scores[j] = score;
+        lines[j].movement.x = cell % WIDTH;
+        lines[j].movement.y = cell / WIDTH;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t cell = lines[i].movement.y * WIDTH + lines[i].movement.x;
+        lines[i].pv[0] = (uint8_t)cell;
+        lines[i].pv_length = 1 + root_analysis_t_get_pv(
+            analysis,
+            opponent,
+            (uint16_t)(own | 1 << cell),
+            key + mark * ROOT_ANALYSIS_POWERS_OF_3[cell],
+            invert_player_color(player_color),
+            1,
+            -scores[i],
+            lines[i].pv + 1);
+        lines[i].score = player_color == PLAYER_O ? scores[i] : -scores[i];
+    }
+
+    free(analysis);
+    return count;
+}
+
+/*****************************************************************
+Searches all the movements 'player_color' can make on the board and
+returns the best one, breaking the ties by 'preference_filter'. The
+score of that movement is stored in 'score'; positive scores favor
+O, negative ones favor X.
+*****************************************************************/
+static movement_t compute_best_movement(
+    board_t* board,
+    PlayerColor player_color,
+    const int preference_filter[HEIGHT][WIDTH],
+    search_context_t* context,
+    int* score)
+{
+    root_line_t line = { { 0, 0 }, 0, 0, { 0 } };
+    TELEMETRY(uint64_t search_start = micros());
+
+    analyze_root_movements(board, 
+                           player_color, 
+                           preference_filter, 
+                           1, 
+                           &line, 
+                           context);
+
+#if SEARCH_TELEMETRY
+    search_telemetry_t* telemetry = &context->telemetry;
+
+    // The search is exhaustive, so it makes up a single iteration.
+    if (telemetry->number_of_iterations < TELEMETRY_MAX_ITERATIONS) {
+        telemetry->iteration_micros[telemetry->number_of_iterations++] =
+            micros() - search_start;
+    }
+
+    search_context_t_trace(context, "search", search_start);
+#endif
+
+    *score = line.score;
+    return line.movement;
+}
+
+/*******************************************************
+Runs AI in order to find the next movement. The score of
+the movement is stored in 'score'.
+*******************************************************/
+static movement_t compute_next_ai_movement(
+    board_t* board,
+    const int preference_filter[HEIGHT][WIDTH],
+    search_context_t* context,
+    int* score)
+{
+    return compute_best_movement(board, 
+                                 PLAYER_O, 
+                                 preference_filter, 
+                                 context, 
+                                 score);
+}
+
+#define GAME_RECORD_MAGIC "TTTR"
+#define GAME_RECORD_VERSION 1
+#define GAME_RECORD_HEADER_SIZE 16
+#define GAME_RECORD_MAX_MOVES 255
+#define GAME_RECORD_MAX_GAME_SIZE 4096
+#define GAME_RECORD_BUFFER_CAPACITY (64 * 1024)
+#define GAME_RECORD_NIBBLE_CELLS 16
+
+#define GAME_RECORD_FLAG_SCORES 0x01 // Moves may carry engine scores.
+#define GAME_RECORD_FLAG_TIMES  0x02 // Moves carry thinking times.
+
+/*******************************************************************
+The binary game record file starts with a 16-byte header:
+
+    offset  size  contents
+         0     4  magic "TTTR"
+         4     1  format version
+         5     1  board width
+         6     1  board height
+         7     1  number of board layers (1 for planar boards)
+         8     1  number of marks in a row needed to win
+         9     1  GAME_RECORD_FLAG_* bits
+        10     2  search depth limit, 0 for none (little-endian)
+        12     4  time budget per move in milliseconds, 0 for none or
+                  for engines given different budgets
+
+It is followed by the games, each prefixed by the varint length of
+its body. A game body consists of:
+
+    varint  number of moves 'n'
+    byte    bits 0-1: result (0 unfinished, 1 X, 2 O, 3 tie),
+            bit 2: O moved first
+    moves   cell indices (y * width + x); two per byte (low nibble
+            first) on boards with at most 16 cells, varints otherwise
+    scores  if GAME_RECORD_FLAG_SCORES: a bitmap of ceil(n / 8) bytes
+            telling which moves are scored, followed by the zigzag
+            varint scores of those moves
+    times   if GAME_RECORD_FLAG_TIMES: n varints in milliseconds
+*******************************************************************/
+typedef struct game_record_header_t
+{
+    uint8_t width;
+    uint8_t height;
+    uint8_t layers;
+    uint8_t row_length;
+    uint8_t flags;
+    uint16_t depth_limit;
+    uint32_t time_budget;
+} game_record_header_t;
+
+/*****************************************************************
+Buffers games and writes them to a game record file. Moves of the
+current game are kept here until the game ends.
+*****************************************************************/
+typedef struct game_record_writer_t
+{
+    FILE* file;
+    bool failed;
+    game_record_header_t header;
+    PlayerColor first_player;
+    size_t number_of_moves;
+    uint16_t cells[GAME_RECORD_MAX_MOVES];
+    bool has_score[GAME_RECORD_MAX_MOVES];
+    int scores[GAME_RECORD_MAX_MOVES];
+    uint32_t times[GAME_RECORD_MAX_MOVES];
+    size_t buffer_length;
+    uint8_t buffer[GAME_RECORD_BUFFER_CAPACITY];
+} game_record_writer_t;
+
+typedef enum RecordOpenStatus
+{
+    RECORD_OPENED,
+    RECORD_OTHER_HEADER, // The file holds games under another header.
+    RECORD_UNWRITABLE,
+} RecordOpenStatus;
+
+/*******************************************************************
+Scans a game record file mapped into memory. Games are handed out as
+views into the mapping, so scanning does not copy anything.
+*******************************************************************/
+typedef struct game_record_reader_t
+{
+    game_record_header_t header;
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} game_record_reader_t;
+
+/****************************************************
+A game inside the mapping of a game record reader.
+****************************************************/
+typedef struct game_record_t
+{
+    size_t number_of_moves;
+    PlayerColor first_player;
+    WinningStatus result;
+    const uint8_t* moves; // The first byte after the game info byte.
+    const uint8_t* end;   // One past the last byte of the game.
+} game_record_t;
+
+/*******************************************************************
+Writes 'value' as a varint (7 bits per byte, the least significant
+group first) to 'out'. Returns the number of bytes written.
+*******************************************************************/
+static size_t encode_varint(uint64_t value, uint8_t* out)
+{
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+/*******************************************************************
+Reads a varint at '*cursor', advancing it. Returns false if the
+varint runs past 'end' or does not fit 64 bits.
+*******************************************************************/
+static bool decode_varint(const uint8_t** cursor,
+                          const uint8_t* end,
+                          uint64_t* value)
+{
+    *value = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*cursor == end) {
+            return false;
+        }
+
+        uint8_t byte = *(*cursor)++;
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint64_t zigzag_encode(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/*************************************************************
+Serializes the header into the GAME_RECORD_HEADER_SIZE bytes.
+*************************************************************/
+static void game_record_header_t_encode(const game_record_header_t* header,
+                                        uint8_t* out)
+{
+    memcpy(out, GAME_RECORD_MAGIC, 4);
+    out[4] = GAME_RECORD_VERSION;
+    out[5] = header->width;
+    out[6] = header->height;
+    out[7] = header->layers;
+    out[8] = header->row_length;
+    out[9] = header->flags;
+    out[10] = (uint8_t)header->depth_limit;
+    out[11] = (uint8_t)(header->depth_limit >> 8);
+    out[12] = (uint8_t)header->time_budget;
+    out[13] = (uint8_t)(header->time_budget >> 8);
+    out[14] = (uint8_t)(header->time_budget >> 16);
+    out[15] = (uint8_t)(header->time_budget >> 24);
+}
+
+/***************************************************************
+Deserializes the header. Returns false on a foreign or corrupt
+header.
+***************************************************************/
+static bool game_record_header_t_decode(game_record_header_t* header,
+                                        const uint8_t* in)
+{
+    if (memcmp(in, GAME_RECORD_MAGIC, 4) != 0 || 
+        in[4] != GAME_RECORD_VERSION) {
+        return false;
+    }
+
+    header->width = in[5];
+    header->height = in[6];
+    header->layers = in[7];
+    header->row_length = in[8];
+    header->flags = in[9];
+    header->depth_limit = (uint16_t)(in[10] | in[11] << 8);
+    header->time_budget = (uint32_t)in[12] 
+                        | (uint32_t)in[13] << 8
+                        | (uint32_t)in[14] << 16
+                        | (uint32_t)in[15] << 24;
+
+    return (size_t)header->width * header->height * header->layers > 0;
+}
+
+/******************************************************
+Returns the number of cells on the board of the header.
+******************************************************/
+static size_t game_record_header_t_cells(const game_record_header_t* header)
+{
+    return (size_t)header->width * header->height * header->layers;
+}
+
+/*************************************************************
+Writes out the buffered games. Returns false on a write error.
+*************************************************************/
+static bool game_record_writer_t_flush(game_record_writer_t* writer)
+{
+    if (writer->buffer_length > 0 &&
+        fwrite(writer->buffer, 1, writer->buffer_length, writer->file) 
+        != writer->buffer_length) {
+        writer->failed = true;
+    }
+
+    writer->buffer_length = 0;
+    return !writer->failed;
+}
+
+/*******************************************************************
+Opens the game record file at 'path' for writing. A missing or empty
+file gets a fresh header; games are appended to an existing file
+only if its header matches 'header'.
+*******************************************************************/
+static RecordOpenStatus game_record_writer_t_open(game_record_writer_t* writer,
+                                                  const wchar_t* path,
+                                                  const game_record_header_t* header)
+{
+    uint8_t encoded_header[GAME_RECORD_HEADER_SIZE];
+    uint8_t existing_header[GAME_RECORD_HEADER_SIZE];
+    size_t existing_length = 0;
+    FILE* existing_file = open_file(path, "rb");
+
+    game_record_header_t_encode(header, encoded_header);
+
+    if (existing_file != NULL) {
+        existing_length = fread(existing_header, 
+                                1, 
+                                GAME_RECORD_HEADER_SIZE, 
+                                existing_file);
+        fclose(existing_file);
+
+        if (existing_length > 0 && 
+            (existing_length != GAME_RECORD_HEADER_SIZE ||
+             memcmp(existing_header, 
+                    encoded_header, 
+                    GAME_RECORD_HEADER_SIZE) != 0)) {
+            return RECORD_OTHER_HEADER;
+        }
+    }
+
+    writer->file = open_file(path, existing_length > 0 ? "ab" : "wb");
+
+    if (writer->file == NULL) {
+        return RECORD_UNWRITABLE;
+    }
+
+    writer->failed = false;
+    writer->header = *header;
+    writer->number_of_moves = 0;
+    writer->buffer_length = 0;
+
+    if (existing_length == 0) {
+        memcpy(writer->buffer, encoded_header, GAME_RECORD_HEADER_SIZE);
+        writer->buffer_length = GAME_RECORD_HEADER_SIZE;
+    }
+
+    return RECORD_OPENED;
+}
+
+/****************************************************************
+Reports why the game record file at 'path' could not be opened.
+****************************************************************/
+static void print_record_open_error(RecordOpenStatus status,
+                                    const wchar_t* path)
+{
+    if (status == RECORD_OTHER_HEADER) {
+        fprintf(stderr, 
+                "%ls holds games of another variant or time budget.\n",
+                path);
+    } else {
+        fprintf(stderr, "Could not record the games to %ls.\n", path);
+    }
+}
+
+/*************************************************
+Starts recording a new game where 'first_player'
+makes the first move.
+*************************************************/
+static void game_record_writer_t_begin_game(game_record_writer_t* writer,
+                                            PlayerColor first_player)
+{
+    writer->first_player = first_player;
+    writer->number_of_moves = 0;
+}
+
+/*****************************************************************
+Records a move to the cell 'cell' of the current game. 'score' is
+ignored unless 'has_score' is set; 'time' is the thinking time in
+milliseconds.
+*****************************************************************/
+static void game_record_writer_t_add_move(game_record_writer_t* writer,
+                                          size_t cell,
+                                          bool has_score,
+                                          int score,
+                                          size_t time)
+{
+    if (writer->number_of_moves == GAME_RECORD_MAX_MOVES) {
+        writer->failed = true;
+        return;
+    }
+
+    size_t i = writer->number_of_moves++;
+    writer->cells[i] = (uint16_t)cell;
+    writer->has_score[i] = has_score;
+    writer->scores[i] = has_score ? score : 0;
+    writer->times[i] = (uint32_t)time;
+}
+
+/*******************************************************************
+Encodes the current game ending with 'result' into the buffer,
+flushing the buffer first if the game might not fit.
+*******************************************************************/
+static void game_record_writer_t_end_game(game_record_writer_t* writer,
+                                          WinningStatus result)
+{
+    uint8_t body[GAME_RECORD_MAX_GAME_SIZE];
+    size_t length = encode_varint(writer->number_of_moves, body);
+    size_t n = writer->number_of_moves;
+    uint8_t info = 0;
+
+    switch (result) {
+    case WIN_X:
+        info = 1;
+        break;
+
+    case WIN_O:
+        info = 2;
+        break;
+
+    case WIN_TIE:
+        info = 3;
+        break;
+
+    default:
+        break;
+    }
+
+    if (writer->first_player == PLAYER_O) {
+        info |= 0x04;
+    }
+
+    body[length++] = info;
+
+    if (game_record_header_t_cells(&writer->header) 
+        <= GAME_RECORD_NIBBLE_CELLS) {
+        for (size_t i = 0; i < n; i += 2) {
+            uint8_t high = i + 1 < n ? (uint8_t)writer->cells[i + 1] : 0;
+            body[length++] = (uint8_t)(writer->cells[i] | high << 4);
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            length += encode_varint(writer->cells[i], body + length);
+        }
+    }
+
+    if (writer->header.flags & GAME_RECORD_FLAG_SCORES) {
+        size_t bitmap_length = (n + 7) / 8;
+        memset(body + length, 0, bitmap_length);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (writer->has_score[i]) {
+                body[length + i / 8] |= (uint8_t)(1 << (i % 8));
+            }
+        }
+
+        length += bitmap_length;
+
+        for (size_t i = 0; i < n; ++i) {
+            if (writer->has_score[i]) {
+                length += encode_varint(zigzag_encode(writer->scores[i]),
+                                        body + length);
+            }
+        }
+    }
+
+    if (writer->header.flags & GAME_RECORD_FLAG_TIMES) {
+        for (size_t i = 0; i < n; ++i) {
+            length += encode_varint(writer->times[i], body + length);
+        }
+    }
+
+    if (writer->buffer_length + length + 10 > GAME_RECORD_BUFFER_CAPACITY) {
+        game_record_writer_t_flush(writer);
+    }
+
+    writer->buffer_length += encode_varint(length, 
+                                           writer->buffer + 
+                                           writer->buffer_length);
+    memcpy(writer->buffer + writer->buffer_length, body, length);
+    writer->buffer_length += length;
+    writer->number_of_moves = 0;
+}
+
+/*******************************************************************
+Flushes and closes the writer. Returns false if anything could not
+be written.
+*******************************************************************/
+static bool game_record_writer_t_close(game_record_writer_t* writer)
+{
+    game_record_writer_t_flush(writer);
+
+    if (fclose(writer->file) != 0) {
+        writer->failed = true;
+    }
+
+    return !writer->failed;
+}
+
+/*****************************************************
+Unmaps the file of the reader.
+*****************************************************/
+static void game_record_reader_t_close(game_record_reader_t* reader)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(reader->data);
+    CloseHandle(reader->mapping);
+    CloseHandle(reader->file);
+#else
+    munmap((void*)reader->data, reader->size);
+#endif
+}
+
+/*******************************************************************
+Maps the game record file at 'path' into memory and reads its header.
+Returns false if the file cannot be mapped or is not a game record.
+*******************************************************************/
+static bool game_record_reader_t_open(game_record_reader_t* reader,
+                                      const wchar_t* path)
+{
+#ifdef _WIN32
+    LARGE_INTEGER file_size;
+
+    reader->file = CreateFileW(path,
+                               GENERIC_READ,
+                               FILE_SHARE_READ,
+                               NULL,
+                               OPEN_EXISTING,
+                               FILE_FLAG_SEQUENTIAL_SCAN,
+                               NULL);
+
+    if (reader->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    if (!GetFileSizeEx(reader->file, &file_size) ||
+        file_size.QuadPart < GAME_RECORD_HEADER_SIZE) {
+        CloseHandle(reader->file);
+        return false;
+    }
+
+    reader->mapping = CreateFileMappingW(reader->file,
+                                         NULL,
+                                         PAGE_READONLY,
+                                         0,
+                                         0,
+                                         NULL);
+
+    if (reader->mapping == NULL) {
+        CloseHandle(reader->file);
+        return false;
+    }
+
+    reader->data = MapViewOfFile(reader->mapping, FILE_MAP_READ, 0, 0, 0);
+    reader->size = (size_t)file_size.QuadPart;
+
+    if (reader->data == NULL) {
+        CloseHandle(reader->mapping);
+        CloseHandle(reader->file);
+        return false;
+    }
+#else
+    char narrow_path[PATH_CAPACITY];
+    struct stat file_status;
+
+    if (!narrow_down_path(path, narrow_path)) {
+        return false;
+    }
+
+    int file = open(narrow_path, O_RDONLY);
+
+    if (file < 0) {
+        return false;
+    }
+
+    if (fstat(file, &file_status) != 0 || 
+        file_status.st_size < GAME_RECORD_HEADER_SIZE) {
+        close(file);
+        return false;
+    }
+
+    reader->size = (size_t)file_status.st_size;
+    reader->data = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (reader->data == MAP_FAILED) {
+        return false;
+    }
+
+    madvise((void*)reader->data, reader->size, MADV_SEQUENTIAL);
+#endif
+
+    reader->offset = GAME_RECORD_HEADER_SIZE;
+
+    if (!game_record_header_t_decode(&reader->header, reader->data)) {
+        game_record_reader_t_close(reader);
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************
+Moves on to the next game. Only the length, the number of moves and
+the info byte are read; the rest of the game is left for
+game_record_t_decode(). Returns false at the end of the file, or if
+the game is corrupt, in which case 'offset' stops short of 'size'.
+*******************************************************************/
+static bool game_record_reader_t_next(game_record_reader_t* reader,
+                                      game_record_t* game)
+{
+    const uint8_t* cursor = reader->data + reader->offset;
+    const uint8_t* end = reader->data + reader->size;
+    uint64_t length;
+    uint64_t number_of_moves;
+
+    if (cursor == end || 
+        !decode_varint(&cursor, end, &length) ||
+        length > (uint64_t)(end - cursor)) {
+        return false;
+    }
+
+    end = cursor + length;
+
+    if (!decode_varint(&cursor, end, &number_of_moves) || 
+        number_of_moves > GAME_RECORD_MAX_MOVES ||
+        cursor == end) {
+        return false;
+    }
+
+    uint8_t info = *cursor++;
+
+    switch (info & 0x03) {
+    case 1:
+        game->result = WIN_X;
+        break;
+
+    case 2:
+        game->result = WIN_O;
+        break;
+
+    case 3:
+        game->result = WIN_TIE;
+        break;
+
+    default:
+        game->result = WIN_NA;
+        break;
+    }
+
+    game->number_of_moves = (size_t)number_of_moves;
+    game->first_player = info & 0x04 ? PLAYER_O : PLAYER_X;
+    game->moves = cursor;
+    game->end = end;
+    reader->offset = (size_t)(end - reader->data);
+    return true;
+}
+
+/*******************************************************************
+Decodes the moves of 'game' into 'cells' and, when the arrays are
+not NULL and the file has them, the scores and the times. All arrays
+must hold GAME_RECORD_MAX_MOVES entries. Returns false on a corrupt
+game.
+*******************************************************************/
+static bool game_record_t_decode(const game_record_t* game,
+                                 const game_record_header_t* header,
+                                 uint16_t* cells,
+                                 bool* has_score,
+                                 int* scores,
+                                 uint32_t* times)
+{
+    const uint8_t* cursor = game->moves;
+    size_t n = game->number_of_moves;
+    size_t number_of_cells = game_record_header_t_cells(header);
+    uint64_t value;
+
+    if (number_of_cells <= GAME_RECORD_NIBBLE_CELLS) {
+        if ((size_t)(game->end - cursor) < (n + 1) / 2) {
+            return false;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            cells[i] = i % 2 == 0 ? cursor[i / 2] & 0x0f : cursor[i / 2] >> 4;
+        }
+
+        cursor += (n + 1) / 2;
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            if (!decode_varint(&cursor, game->end, &value) ||
+                value >= number_of_cells) {
+                return false;
+            }
+
+            cells[i] = (uint16_t)value;
+        }
+    }
+
+    if (header->flags & GAME_RECORD_FLAG_SCORES) {
+        const uint8_t* bitmap = cursor;
+
+        if ((size_t)(game->end - cursor) < (n + 7) / 8) {
+            return false;
+        }
+
+        cursor += (n + 7) / 8;
+
+        for (size_t i = 0; i < n; ++i) {
+            bool scored = (bitmap[i / 8] >> (i % 8)) & 1;
+            int64_t score = 0;
+
+            if (scored) {
+                if (!decode_varint(&cursor, game->end, &value)) {
+                    return false;
+                }
+
+                score = zigzag_decode(value);
+            }
+
+            if (has_score != NULL) {
+                has_score[i] = scored;
+                scores[i] = (int)score;
+            }
+        }
+    } else if (has_score != NULL) {
+        memset(has_score, 0, n * sizeof(bool));
+    }
+
+    if (header->flags & GAME_RECORD_FLAG_TIMES) {
+        for (size_t i = 0; i < n; ++i) {
+            if (!decode_varint(&cursor, game->end, &value)) {
+                return false;
+            }
+
+            if (times != NULL) {
+                times[i] = (uint32_t)value;
+            }
+        }
+    } else if (times != NULL) {
+        memset(times, 0, n * sizeof(uint32_t));
+    }
+
+    return cursor == game->end;
+}
+
+/*******************************************************************
+Returns the number of set bits in 'bits'.
+*******************************************************************/
+static int popcount64(uint64_t bits)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return (int)__popcnt64(bits);
+#elif defined(__GNUC__)
+    return __builtin_popcountll(bits);
+#else
+    bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+    bits = (bits & 0x3333333333333333ULL) + 
+           ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int)((bits * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/*******************************************************
+Returns the index of the lowest set bit of 'bits' != 0.
+*******************************************************/
+static size_t bit_scan_forward64(uint64_t bits)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#elif defined(__GNUC__)
+    return (size_t)__builtin_ctzll(bits);
+#else
+    size_t index = 0;
+
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+
+    return index;
+#endif
+}
+
+/*******************************************************************
+Returns the next number of the SplitMix64 sequence kept in 'state'.
+Used for filling the Zobrist keys deterministically.
+*******************************************************************/
+static uint64_t split_mix_64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+#define SEARCH_WIN_SCORE 100000
+#define SEARCH_MAX_PLY 128
+
+// Scores beyond this are wins (or losses) in a known number of plies.
+#define SEARCH_WIN_THRESHOLD (SEARCH_WIN_SCORE - SEARCH_MAX_PLY)
+
+/*******************************************************************
+Win scores count the plies from the root; in the table they count
+the plies from the node instead, so that they stay valid wherever
+the node is reached from.
+*******************************************************************/
+static int score_to_table(int score, int ply)
+{
+    if (score > SEARCH_WIN_THRESHOLD) {
+        return score + ply;
+    }
+
+    if (score < -SEARCH_WIN_THRESHOLD) {
+        return score - ply;
+    }
+
+    return score;
+}
+
+static int score_from_table(int score, int ply)
+{
+    if (score > SEARCH_WIN_THRESHOLD) {
+        return score - ply;
+    }
+
+    if (score < -SEARCH_WIN_THRESHOLD) {
+        return score + ply;
+    }
+
+    return score;
+}
+
+/**************************************
+An entry of a transposition table.
+**************************************/
+typedef struct table_entry_t
+{
+    uint64_t key;
+    int32_t score;    // In the table form, see score_to_table().
+    int8_t depth;
+    uint8_t bound;      // TableBound.
+    uint8_t movement;   // The best cell found.
+    uint8_t generation; // The search that stored the entry.
+} table_entry_t;
+
+/*******************************************************************
+A transposition table: a power of two of entries, addressed by the
+low bits of the Zobrist key of the position. The table outlives the
+searches of a game; each search is a new generation.
+*******************************************************************/
+typedef struct transposition_table_t
+{
+    table_entry_t* entries;
+    size_t mask;
+    uint8_t generation; // The generation of the current search.
+} transposition_table_t;
+
+/*******************************************************************
+Allocates 2^'bits' empty entries. Returns false if out of memory.
+*******************************************************************/
+static bool transposition_table_t_init(transposition_table_t* table,
+                                       size_t bits)
+{
+    table->entries = calloc((size_t)1 << bits, sizeof(table_entry_t));
+    table->mask = ((size_t)1 << bits) - 1;
+    table->generation = 0;
+    return table->entries != NULL;
+}
+
+static void transposition_table_t_free(transposition_table_t* table)
+{
+    free(table->entries);
+}
+
+/*******************************************************************
+Starts a new generation. The entries of the earlier searches still
+answer probes, but give up their slots to any entry of the new one.
+*******************************************************************/
+static void transposition_table_t_age(transposition_table_t* table)
+{
+    table->generation++;
+}
+
+/*******************************************************************
+Prepares the tables of an engine for the search of the next movement
+of the game: 'table' and 'history', the history scores of both
+players on 'cells' cells, X's first. The previous searches most
+likely covered the position already, so their table entries stay
+until newer ones need the slots, and the root probe usually finds
+their best movement to try first. Their history scores are halved
+rather than forgotten.
+*******************************************************************/
+static void age_search_tables(transposition_table_t* table,
+                              uint32_t* history,
+                              size_t cells)
+{
+    transposition_table_t_age(table);
+
+    for (size_t i = 0; i < 2 * cells; ++i) {
+        history[i] >>= 1;
+    }
+}
+
+/*******************************************************************
+Returns the entry of the position 'key', or NULL if the table holds
+none, counting the probe in the telemetry of the context.
+*******************************************************************/
+static const table_entry_t* 
+transposition_table_t_probe(const transposition_table_t* table,
+                            uint64_t key,
+                            search_context_t* context)
+{
+    const table_entry_t* entry = &table->entries[key & table->mask];
+
+    TELEMETRY(context->telemetry.table_probes++);
+
+    if (entry->bound == BOUND_NONE) {
+        return NULL;
+    }
+
+    if (entry->key != key) {
+        TELEMETRY(context->telemetry.table_collisions++);
+        return NULL;
+    }
+
+    TELEMETRY(context->telemetry.table_hits++);
+    (void)context;
+    return entry;
+}
+
+/*******************************************************************
+Stores the result of searching the position 'key' 'depth' plies
+deep at the distance 'ply' from the root, unless that evicts a
+deeper search of another position by the current generation. The
+bound follows from how 'score' relates to the window ('alpha',
+'beta') of the search.
+*******************************************************************/
+static void transposition_table_t_store(transposition_table_t* table,
+                                        uint64_t key,
+                                        int depth,
+                                        int ply,
+                                        int score,
+                                        int alpha,
+                                        int beta,
+                                        size_t movement)
+{
+    table_entry_t* entry = &table->entries[key & table->mask];
+
+    if (entry->bound != BOUND_NONE && 
+        entry->key != key && 
+        entry->generation == table->generation &&
+        entry->depth > depth) {
+        return;
+    }
+
+    entry->key = key;
+    entry->generation = table->generation;
+    entry->score = score_to_table(score, ply);
+    entry->depth = (int8_t)MIN(depth, INT8_MAX);
+    entry->movement = (uint8_t)movement;
+    entry->bound = score <= alpha ? BOUND_UPPER :
+                   score >= beta ? BOUND_LOWER : BOUND_EXACT;
+}
+
+/*******************************************************************
+Returns true if the table entry settles the search of its position
+'depth' plies deep at the distance 'ply' from the root within the
+window ('alpha', 'beta'), storing the score in 'score'.
+*******************************************************************/
+static bool table_entry_t_cuts_off(const table_entry_t* entry,
+                                   int depth,
+                                   int ply,
+                                   int alpha,
+                                   int beta,
+                                   int* score)
+{
+    if (entry->depth < depth) {
+        return false;
+    }
+
+    *score = score_from_table(entry->score, ply);
+
+    return entry->bound == BOUND_EXACT ||
+           (entry->bound == BOUND_LOWER && *score >= beta) ||
+           (entry->bound == BOUND_UPPER && *score <= alpha);
+}
+
+/*******************************************************************
+Moves the best rated of the movements 'first' to 'count - 1' to the
+position 'first'.
+*******************************************************************/
+static void select_movement(uint8_t* movements,
+                            int* ratings,
+                            size_t first,
+                            size_t count)
+{
+    size_t best = first;
+
+    for (size_t i = first + 1; i < count; ++i) {
+        if (ratings[i] > ratings[best]) {
+            best = i;
+        }
+    }
+
+    uint8_t movement = movements[first];
+    int rating = ratings[first];
+    movements[first] = movements[best];
+    ratings[first] = ratings[best];
+    movements[best] = movement;
+    ratings[best] = rating;
+}
+
+#define QUBIC_SIZE 4
+#define QUBIC_CELLS 64
+#define QUBIC_LINES 76
+#define QUBIC_MAX_LINES_PER_CELL 7
+#define QUBIC_TABLE_BITS 20
+#define QUBIC_DEFAULT_TIME_BUDGET 1000
+
+/*******************************************************************
+A cell (x, y, z) of the 4x4x4 board is the bit z * 16 + y * 4 + x.
+*******************************************************************/
+static uint64_t QUBIC_LINE_MASKS[QUBIC_LINES];
+
+static uint8_t QUBIC_CELL_LINES[QUBIC_CELLS][QUBIC_MAX_LINES_PER_CELL];
+static uint8_t QUBIC_CELL_LINE_COUNTS[QUBIC_CELLS];
+
+static uint64_t QUBIC_ZOBRIST_KEYS[2][QUBIC_CELLS];
+static uint64_t QUBIC_ZOBRIST_O_TO_MOVE;
+
+/*******************************************************************
+Moves on the line: the axes, the diagonals of the planes and the
+diagonals of the cube, each counted in one direction only.
+*******************************************************************/
+static const int QUBIC_DIRECTIONS[13][3] = {
+    { 1,  0,  0 }, { 0,  1,  0 }, { 0,  0,  1 },
+    { 1,  1,  0 }, { 1, -1,  0 }, { 1,  0,  1 }, 
+    { 1,  0, -1 }, { 0,  1,  1 }, { 0,  1, -1 },
+    { 1,  1,  1 }, { 1,  1, -1 }, { 1, -1,  1 }, { 1, -1, -1 },
+};
+
+/****************************************************************
+Line weights of the evaluation indexed by the number of the marks
+of a single player on a line not blocked by the other player.
+****************************************************************/
+static const int QUBIC_LINE_WEIGHTS[QUBIC_SIZE] = { 0, 1, 8, 64 };
+
+static bool qubic_is_inside(int x, int y, int z)
+{
+    return 0 <= x && x < QUBIC_SIZE && 
+           0 <= y && y < QUBIC_SIZE && 
+           0 <= z && z < QUBIC_SIZE;
+}
+
+/******************************************************************
+Precomputes the 76 winning lines, the lines through each cell and
+the Zobrist keys.
+******************************************************************/
+static void load_qubic_tables()
+{
+    size_t number_of_lines = 0;
+    uint64_t seed = 0x51b1c;
+
+    for (int z = 0; z < QUBIC_SIZE; ++z) {
+        for (int y = 0; y < QUBIC_SIZE; ++y) {
+            for (int x = 0; x < QUBIC_SIZE; ++x) {
+                for (size_t d = 0; d < 13; ++d) {
+                    int dx = QUBIC_DIRECTIONS[d][0];
+                    int dy = QUBIC_DIRECTIONS[d][1];
+                    int dz = QUBIC_DIRECTIONS[d][2];
+
+                    // Start the lines only at their first cell.
+                    if (qubic_is_inside(x - dx, y - dy, z - dz) ||
+                        !qubic_is_inside(x + 3 * dx, 
+                                         y + 3 * dy, 
+                                         z + 3 * dz)) {
+                        continue;
+                    }
+
+                    uint64_t mask = 0;
+
+                    for (int i = 0; i < QUBIC_SIZE; ++i) {
+                        size_t cell = (size_t)((z + i * dz) * 16 + 
+                                               (y + i * dy) * 4 + 
+                                               (x + i * dx));
+                        mask |= 1ULL << cell;
+                        QUBIC_CELL_LINES[cell][QUBIC_CELL_LINE_COUNTS[cell]++] =
+                            (uint8_t)number_of_lines;
+                    }
+
+                    QUBIC_LINE_MASKS[number_of_lines++] = mask;
+                }
+            }
+        }
+    }
+
+    for (size_t cell = 0; cell < QUBIC_CELLS; ++cell) {
+        QUBIC_ZOBRIST_KEYS[PLAYER_X][cell] = split_mix_64(&seed);
+        QUBIC_ZOBRIST_KEYS[PLAYER_O][cell] = split_mix_64(&seed);
+    }
+
+    QUBIC_ZOBRIST_O_TO_MOVE = split_mix_64(&seed);
+}
+
+/*******************************************************************
+The 4x4x4 board as one bitboard per player.
+*******************************************************************/
+typedef struct qubic_board_t
+{
+    uint64_t marks[2]; // Indexed by the player color.
+    uint64_t key;      // The Zobrist key of the marks.
+} qubic_board_t;
+
+static uint64_t qubic_board_t_empty_cells(const qubic_board_t* board)
+{
+    return ~(board->marks[PLAYER_X] | board->marks[PLAYER_O]);
+}
+
+/*************************************************************
+Puts (or, being an involution, takes away) the mark of the
+player to the cell.
+*************************************************************/
+static void qubic_board_t_toggle(qubic_board_t* board,
+                                 size_t cell,
+                                 PlayerColor player_color)
+{
+    board->marks[player_color] ^= 1ULL << cell;
+    board->key ^= QUBIC_ZOBRIST_KEYS[player_color][cell];
+}
+
+/*************************
+Checks the winning status.
+*************************/
+static WinningStatus qubic_board_t_get_winner_status(
+    const qubic_board_t* board)
+{
+    for (size_t i = 0; i < QUBIC_LINES; ++i) {
+        uint64_t line = QUBIC_LINE_MASKS[i];
+
+        if ((board->marks[PLAYER_X] & line) == line) {
+            return WIN_X;
+        }
+
+        if ((board->marks[PLAYER_O] & line) == line) {
+            return WIN_O;
+        }
+    }
+
+    return qubic_board_t_empty_cells(board) == 0 ? WIN_TIE : WIN_NA;
+}
+
+/*******************************************************************
+Returns the cells that would complete a line of 'own' marks, empty
+or not; the lines blocked by the 'opponent' are skipped.
+*******************************************************************/
+static uint64_t qubic_completing_cells(uint64_t own, uint64_t opponent)
+{
+    uint64_t cells = 0;
+
+    for (size_t i = 0; i < QUBIC_LINES; ++i) {
+        uint64_t line = QUBIC_LINE_MASKS[i];
+
+        if ((line & opponent) == 0 && popcount64(line & own) == 3) {
+            cells |= line & ~own;
+        }
+    }
+
+    return cells;
+}
+
+/*******************************************************************
+Evaluates the board from the point of view of 'player_color' by the
+lines each player still can complete.
+*******************************************************************/
+static int qubic_board_t_evaluate(const qubic_board_t* board,
+                                  PlayerColor player_color)
+{
+    uint64_t own = board->marks[player_color];
+    uint64_t opponent = board->marks[invert_player_color(player_color)];
+    int score = 0;
+
+    for (size_t i = 0; i < QUBIC_LINES; ++i) {
+        uint64_t line = QUBIC_LINE_MASKS[i];
+        int own_count = popcount64(line & own);
+        int opponent_count = popcount64(line & opponent);
+
+        if (opponent_count == 0) {
+            score += QUBIC_LINE_WEIGHTS[own_count];
+        } else if (own_count == 0) {
+            score -= QUBIC_LINE_WEIGHTS[opponent_count];
+        }
+    }
+
+    return score;
+}
+
+/*******************************************************************
+Rates a move of 'player_color' to 'cell' for the move ordering: the
+threats (lines to be completed the next move) it makes, double
+threats foremost, then the threats of the opponent it takes away,
+and then the lines through the cell still open for the player.
+*******************************************************************/
+static int qubic_board_t_rate_movement(const qubic_board_t* board,
+                                       PlayerColor player_color,
+                                       size_t cell)
+{
+    uint64_t own = board->marks[player_color];
+    uint64_t opponent = board->marks[invert_player_color(player_color)];
+    int threats = 0;
+    int blocks = 0;
+    int potential = 0;
+
+    for (size_t i = 0; i < QUBIC_CELL_LINE_COUNTS[cell]; ++i) {
+        uint64_t line = QUBIC_LINE_MASKS[QUBIC_CELL_LINES[cell][i]];
+        int own_count = popcount64(line & own);
+        int opponent_count = popcount64(line & opponent);
+
+        if (opponent_count == 0) {
+            threats += own_count == 2;
+            potential += own_count + 1;
+        } else if (own_count == 0) {
+            blocks += opponent_count == 2;
+        }
+    }
+
+    return (threats >= 2 ? 1 << 20 : 0) + 
+           threats * 4096 + 
+           blocks * 512 + 
+           potential * 8;
+}
+
+/*******************************************************************
+The Qubic search: an iteratively deepened alpha-beta search with a
+transposition table and a history heuristic, stopping when the time
+budget of the move runs out.
+*******************************************************************/
+typedef struct qubic_engine_t
+{
+    transposition_table_t table;
+    uint32_t history[2][QUBIC_CELLS];
+    bool use_history;
+    uint32_t time_budget;      // Milliseconds per move.
+    int max_depth;
+    uint64_t deadline;         // micros() at which the search stops.
+    bool stopped;
+    search_context_t* context; // The context of the current search.
+} qubic_engine_t;
+
+/*******************************************************************
+Applies the settings and allocates the transposition table. Returns
+false if out of memory.
+*******************************************************************/
+static bool qubic_engine_t_init(qubic_engine_t* engine, 
+                                const engine_settings_t* settings)
+{
+    engine->time_budget = settings->time_budget != 0 
+        ? settings->time_budget 
+        : QUBIC_DEFAULT_TIME_BUDGET;
+    engine->max_depth = settings->max_depth != 0 
+        ? (int)MIN(settings->max_depth, QUBIC_CELLS) 
+        : QUBIC_CELLS;
+    engine->use_history = !settings->no_history;
+    memset(engine->history, 0, sizeof(engine->history));
+    return transposition_table_t_init(&engine->table, 
+                                      settings->table_bits != 0 
+                                          ? settings->table_bits 
+                                          : QUBIC_TABLE_BITS);
+}
+
+static void qubic_engine_t_free(qubic_engine_t* engine)
+{
+    transposition_table_t_free(&engine->table);
+}
+
+/****************************************************
+Starts the search of the next movement of the game.
+****************************************************/
+static void qubic_engine_t_age(qubic_engine_t* engine)
+{
+    age_search_tables(&engine->table, engine->history[0], QUBIC_CELLS);
+}
+
+/*******************************************************************
+Lists the movements worth trying for 'player_color', rated for the
+move ordering: only the blocking ones when the opponent threatens to
+win. Returns the number of the movements.
+*******************************************************************/
+static size_t qubic_engine_t_generate_movements(qubic_engine_t* engine,
+                                                const qubic_board_t* board,
+                                                PlayerColor player_color,
+                                                uint64_t candidates,
+                                                int table_movement,
+                                                uint8_t* movements,
+                                                int* ratings)
+{
+    size_t count = 0;
+
+    while (candidates != 0) {
+        size_t cell = bit_scan_forward64(candidates);
+        candidates &= candidates - 1;
+
+        movements[count] = (uint8_t)cell;
+        ratings[count] = (int)cell == table_movement 
+            ? POSITIVE_INFINITY
+            : qubic_board_t_rate_movement(board, player_color, cell) + 
+              (engine->use_history 
+                  ? (int)MIN(engine->history[player_color][cell], 1u << 16)
+                  : 0);
+        count++;
+    }
+
+    return count;
+}
+
+/*******************************************************************
+Searches the board with 'player_color' to move 'depth' plies deep,
+returning the score from the point of view of 'player_color'. 'ply'
+is the distance from the root.
+*******************************************************************/
+static int qubic_engine_t_search(qubic_engine_t* engine,
+                                 qubic_board_t* board,
+                                 PlayerColor player_color,
+                                 int depth,
+                                 int ply,
+                                 int alpha,
+                                 int beta)
+{
+    search_context_t* context = engine->context;
+    PlayerColor opponent_color = invert_player_color(player_color);
+    uint64_t own = board->marks[player_color];
+    uint64_t opponent = board->marks[opponent_color];
+    uint64_t empty = qubic_board_t_empty_cells(board);
+
+    context->nodes++;
+    TELEMETRY(context->telemetry.nodes_per_depth[
+                  MIN(ply, TELEMETRY_MAX_DEPTH - 1)]++);
+
+    if ((context->nodes & 1023) == 0 && micros() >= engine->deadline) {
+        engine->stopped = true;
+    }
+
+    if (engine->stopped || empty == 0) {
+        return 0;
+    }
+
+    if (qubic_completing_cells(own, opponent) & empty) {
+        return SEARCH_WIN_SCORE - (ply + 1);
+    }
+
+    uint64_t forced = qubic_completing_cells(opponent, own) & empty;
+
+    if (popcount64(forced) >= 2) {
+        // Blocking one line leaves the other one to the opponent.
+        return -(SEARCH_WIN_SCORE - (ply + 2));
+    }
+
+    if (depth <= 0 && forced == 0) {
+        return qubic_board_t_evaluate(board, player_color);
+    }
+
+    uint64_t key = board->key ^ 
+        (player_color == PLAYER_O ? QUBIC_ZOBRIST_O_TO_MOVE : 0);
+    const table_entry_t* entry = 
+        transposition_table_t_probe(&engine->table, key, context);
+    int table_movement = entry != NULL ? entry->movement : -1;
+    int table_score;
+
+    if (entry != NULL && 
+        table_entry_t_cuts_off(entry, depth, ply, alpha, beta, &table_score)) {
+        return table_score;
+    }
+
+    uint8_t movements[QUBIC_CELLS];
+    int ratings[QUBIC_CELLS];
+    size_t count = 
+        qubic_engine_t_generate_movements(engine,
+                                          board,
+                                          player_color,
+                                          forced != 0 ? forced : empty,
+                                          table_movement,
+                                          movements,
+                                          ratings);
+
+    // A forced block does not count as a ply.
+    int next_depth = forced != 0 ? depth : depth - 1;
+    int original_alpha = alpha;
+    int best_score = NEGATIVE_INFINITY;
+    uint8_t best_movement = movements[0];
+
+    for (size_t i = 0; i < count; ++i) {
+        select_movement(movements, ratings, i, count);
+
+        size_t cell = movements[i];
+        qubic_board_t_toggle(board, cell, player_color);
+        int score = -qubic_engine_t_search(engine,
+                                           board,
+                                           opponent_color,
+                                           next_depth,
+                                           ply + 1,
+                                           -beta,
+                                           -alpha);
+        qubic_board_t_toggle(board, cell, player_color);
+
+        if (engine->stopped) {
+            return 0;
+        }
+
+        if (score > best_score) {
+            best_score = score;
+            best_movement = (uint8_t)cell;
+        }
+
+        alpha = MAX(alpha, score);
+
+        if (alpha >= beta) {
+            engine->history[player_color][cell] += (uint32_t)(depth * depth);
+            TELEMETRY(context->telemetry.cutoffs_per_index[i]++);
+            break;
+        }
+    }
+
+    transposition_table_t_store(&engine->table,
+                                key,
+                                depth,
+                                ply,
+                                best_score,
+                                original_alpha,
+                                beta,
+                                best_movement);
+
+    return best_score;
+}
+
+/*******************************************************************
+Finds the best movement of 'player_color' within the time budget.
+The score of the movement is stored in 'score'; positive scores favor
+O, negative ones favor X.
+*******************************************************************/
+static size_t qubic_engine_t_compute_movement(qubic_engine_t* engine,
+                                              qubic_board_t* board,
+                                              PlayerColor player_color,
+                                              search_context_t* context,
+                                              int* score)
+{
+    PlayerColor opponent_color = invert_player_color(player_color);
+    uint64_t own = board->marks[player_color];
+    uint64_t opponent = board->marks[opponent_color];
+    uint64_t empty = qubic_board_t_empty_cells(board);
+    uint64_t winning = qubic_completing_cells(own, opponent) & empty;
+    uint64_t forced = qubic_completing_cells(opponent, own) & empty;
+    uint64_t search_start = micros();
+    uint8_t movements[QUBIC_CELLS];
+    int ratings[QUBIC_CELLS];
+    size_t best_movement;
+    int best_score = 0;
+
+    engine->context = context;
+    engine->deadline = search_start + (uint64_t)engine->time_budget * 1000;
+    engine->stopped = false;
+    qubic_engine_t_age(engine);
+
+    if (winning != 0) {
+        *score = player_color == PLAYER_O ? SEARCH_WIN_SCORE 
+                                          : -SEARCH_WIN_SCORE;
+        return bit_scan_forward64(winning);
+    }
+
+    const table_entry_t* entry = transposition_table_t_probe(
+        &engine->table,
+        board->key ^ (player_color == PLAYER_O ? QUBIC_ZOBRIST_O_TO_MOVE : 0),
+        context);
+    size_t count = 
+        qubic_engine_t_generate_movements(engine,
+                                          board,
+                                          player_color,
+                                          forced != 0 ? forced : empty,
+                                          entry != NULL ? entry->movement : -1,
+                                          movements,
+                                          ratings);
+
+    select_movement(movements, ratings, 0, count);
+    best_movement = movements[0];
+
+    for (int depth = 1; 
+         depth <= MIN(popcount64(empty), engine->max_depth); 
+         ++depth) {
+        TELEMETRY(uint64_t iteration_start = micros());
+        int alpha = NEGATIVE_INFINITY;
+        size_t iteration_best_movement = best_movement;
+        size_t searched = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            // Search the best movement so far first, then the rest
+            // in the order of their ratings.
+            if (i == 0) {
+                ratings[0] = POSITIVE_INFINITY;
+            } else {
+                select_movement(movements, ratings, i, count);
+            }
+
+            size_t cell = movements[i];
+            qubic_board_t_toggle(board, cell, player_color);
+            int tentative_score = -qubic_engine_t_search(engine,
+                                                         board,
+                                                         opponent_color,
+                                                         depth - 1,
+                                                         1,
+                                                         NEGATIVE_INFINITY,
+                                                         -alpha);
+            qubic_board_t_toggle(board, cell, player_color);
+
+            if (engine->stopped) {
+                break;
+            }
+
+            searched++;
+            ratings[i] = tentative_score;
+
+            if (tentative_score > alpha) {
+                alpha = tentative_score;
+                iteration_best_movement = cell;
+            }
+        }
+
+        if (searched > 0) {
+            best_movement = iteration_best_movement;
+            best_score = alpha;
+        }
+
+        // Put the best movement in front for the next iteration.
+        for (size_t i = 0; i < count; ++i) {
+            if (movements[i] == best_movement) {
+                ratings[i] = ratings[0];
+                movements[i] = movements[0];
+                movements[0] = (uint8_t)best_movement;
+                break;
+            }
+        }
+
+#if SEARCH_TELEMETRY
+        search_telemetry_t* telemetry = &context->telemetry;
+
+        if (telemetry->number_of_iterations < TELEMETRY_MAX_ITERATIONS) {
+            telemetry->iteration_micros[telemetry->number_of_iterations++] =
+                micros() - iteration_start;
+        }
+
+        search_context_t_trace(context, "iteration", iteration_start);
+#endif
+
+        if (engine->stopped || 
+            best_score > SEARCH_WIN_THRESHOLD ||
+            best_score < -SEARCH_WIN_THRESHOLD) {
+            break;
+        }
+    }
+
+    TELEMETRY(search_context_t_trace(context, "search", search_start));
+    *score = player_color == PLAYER_O ? best_score : -best_score;
+    return best_movement;
+}
+
+#define QUBIC_LAYER_SPRITE_WIDTH  (QUBIC_SIZE * (BOARD_CELL_SPRITE_WIDTH + 1) + 1)
+#define QUBIC_LAYER_SPRITE_HEIGHT (QUBIC_SIZE * (BOARD_CELL_SPRITE_HEIGHT + 1) + 1)
+#define QUBIC_SPRITE_WIDTH        (2 * QUBIC_LAYER_SPRITE_WIDTH + 3)
+#define QUBIC_SPRITE_HEIGHT       (2 * (QUBIC_LAYER_SPRITE_HEIGHT + 1))
+
+/*******************************************************************
+Prints the board as four layers, two by two, each drawn like the
+3x3 board with the cell numbers 1 to 64 on the empty cells.
+*******************************************************************/
+static void qubic_board_t_print(const qubic_board_t* board)
+{
+    char sprite[QUBIC_SPRITE_HEIGHT][QUBIC_SPRITE_WIDTH + 1];
+
+    memset(sprite, ' ', sizeof(sprite));
+
+    for (size_t z = 0; z < QUBIC_SIZE; ++z) {
+        size_t origin_x = (z % 2) * (QUBIC_LAYER_SPRITE_WIDTH + 3);
+        size_t origin_y = (z / 2) * (QUBIC_LAYER_SPRITE_HEIGHT + 1);
+        char title[16];
+        int title_length = sprintf(title, "Layer %zu", z + 1);
+
+        memcpy(&sprite[origin_y][origin_x], title, (size_t)title_length);
+        origin_y++;
+
+        for (size_t y = 0; y < QUBIC_LAYER_SPRITE_HEIGHT; ++y) {
+            for (size_t x = 0; x < QUBIC_LAYER_SPRITE_WIDTH; ++x) {
+                bool horizontal = y % (BOARD_CELL_SPRITE_HEIGHT + 1) == 0;
+                bool vertical = x % (BOARD_CELL_SPRITE_WIDTH + 1) == 0;
+
+                sprite[origin_y + y][origin_x + x] = 
+                    horizontal && vertical ? '+' :
+                    horizontal ? '-' :
+                    vertical ? '|' : ' ';
+            }
+        }
+
+        for (size_t y = 0; y < QUBIC_SIZE; ++y) {
+            for (size_t x = 0; x < QUBIC_SIZE; ++x) {
+                size_t cell = z * 16 + y * 4 + x;
+                size_t cell_x = 
+                    origin_x + (BOARD_CELL_SPRITE_WIDTH + 1) * x + 1;
+                size_t cell_y = 
+                    origin_y + (BOARD_CELL_SPRITE_HEIGHT + 1) * y + 1;
+
+                for (size_t char_y = 0; 
+                     char_y < BOARD_CELL_SPRITE_HEIGHT; 
+                     ++char_y) {
+                    for (size_t char_x = 0; 
+                         char_x < BOARD_CELL_SPRITE_WIDTH; 
+                         ++char_x) {
+                        char* ch = &sprite[cell_y + char_y][cell_x + char_x];
+
+                        if (board->marks[PLAYER_X] >> cell & 1) {
+                            *ch = BOARD_X_SPRITE[char_y][char_x];
+                        } else if (board->marks[PLAYER_O] >> cell & 1) {
+                            *ch = BOARD_O_SPRITE[char_y][char_x];
+                        }
+                    }
+                }
+
+                if (((board->marks[PLAYER_X] | 
+                      board->marks[PLAYER_O]) >> cell & 1) == 0) {
+                    char number[4];
+                    int length = sprintf(number, "%zu", cell + 1);
+                    memcpy(&sprite[cell_y + 1][cell_x + 3 - (length > 1)],
+                           number,
+                           (size_t)length);
+                }
+            }
+        }
+    }
+
+    for (size_t y = 0; y < QUBIC_SPRITE_HEIGHT; ++y) {
+        size_t length = QUBIC_SPRITE_WIDTH;
+
+        while (length > 0 && sprite[y][length - 1] == ' ') {
+            length--;
+        }
+
+        sprite[y][length] = '\0';
+        puts(sprite[y]);
+    }
+}
+
+/*******************************************************************
+Reads a cell of the 4x4x4 board from the user, either as a number
+from 1 to 64 or as the layer, the row and the column, each from 1 to
+4. Returns false on the end of the input.
+*******************************************************************/
+static bool qubic_board_t_read_movement(const qubic_board_t* board,
+                                        size_t* cell)
+{
+    char line[64];
+
+    while (true) {
+        unsigned layer, row, column;
+        char trailing;
+
+        printf("Please enter your desired move "
+               "(1-64, or layer row column): ");
+
+        if (fgets(line, sizeof(line), stdin) == NULL) {
+            return false;
+        }
+
+        if (sscanf(line, "%u %u %u %c", &layer, &row, &column, &trailing) 
+            == 3) {
+            if (layer < 1 || layer > 4 || row < 1 || row > 4 || 
+                column < 1 || column > 4) {
+                continue;
+            }
+
+            *cell = (layer - 1) * 16 + (row - 1) * 4 + (column - 1);
+        } else if (sscanf(line, "%u %c", &layer, &trailing) == 1 && 
+                   layer >= 1 && layer <= QUBIC_CELLS) {
+            *cell = layer - 1;
+        } else {
+            continue;
+        }
+
+        if (qubic_board_t_empty_cells(board) >> *cell & 1) {
+            return true;
+        }
+    }
+}
+
+#define ULTIMATE_BOARDS 9
+#define ULTIMATE_CELLS 81
+#define ULTIMATE_ANY_BOARD 9 // Any open sub-board may be played.
+#define ULTIMATE_FULL_BOARD 0x1ff
+#define ULTIMATE_TABLE_BITS 20
+#define ULTIMATE_DEFAULT_TIME_BUDGET 1000
+
+/*******************************************************************
+The lines of a 3x3 board as 9-bit masks, the cell (x, y) being the
+bit y * 3 + x. Both the sub-boards and the meta-board use them.
+*******************************************************************/
+static const uint16_t ULTIMATE_LINES[8] = {
+    0x007, 0x038, 0x1c0, // Rows.
+    0x049, 0x092, 0x124, // Columns.
+    0x111, 0x054,        // Diagonals.
+};
+
+/***********************************************
+Favor the center, then the corners, then the rest.
+***********************************************/
+static const int ULTIMATE_BOARD_WEIGHTS[ULTIMATE_BOARDS] = {
+    3, 2, 3,
+    2, 4, 2,
+    3, 2, 3,
+};
+
+// Indexed by the number of the sub-boards won on an open meta line.
+static const int ULTIMATE_META_LINE_WEIGHTS[3] = { 0, 30, 150 };
+
+// Indexed by the number of the marks on an open line of a sub-board.
+static const int ULTIMATE_LINE_WEIGHTS[3] = { 0, 1, 4 };
+
+// ULTIMATE_WINS[mask] tells whether the 9-bit 'mask' holds a line.
+static uint8_t ULTIMATE_WINS[ULTIMATE_FULL_BOARD + 1];
+
+// The cells completing a line of the 9-bit mask, occupied or not.
+static uint16_t ULTIMATE_COMPLETIONS[ULTIMATE_FULL_BOARD + 1];
+
+static uint64_t ULTIMATE_ZOBRIST_KEYS[2][ULTIMATE_CELLS];
+static uint64_t ULTIMATE_ZOBRIST_FORCED_BOARDS[ULTIMATE_BOARDS + 1];
+static uint64_t ULTIMATE_ZOBRIST_O_TO_MOVE;
+
+/*******************************************************************
+Precomputes the win table of all the 512 sub-board masks, their
+completing cells and the Zobrist keys.
+*******************************************************************/
+static void load_ultimate_tables()
+{
+    uint64_t seed = 0x3773;
+
+    for (size_t mask = 0; mask <= ULTIMATE_FULL_BOARD; ++mask) {
+        for (size_t i = 0; i < 8; ++i) {
+            if ((mask & ULTIMATE_LINES[i]) == ULTIMATE_LINES[i]) {
+                ULTIMATE_WINS[mask] = 1;
+            }
+        }
+    }
+
+    for (size_t mask = 0; mask <= ULTIMATE_FULL_BOARD; ++mask) {
+        ULTIMATE_COMPLETIONS[mask] = 0;
+
+        for (size_t cell = 0; cell < 9; ++cell) {
+            if (!ULTIMATE_WINS[mask] && ULTIMATE_WINS[mask | 1 << cell]) {
+                ULTIMATE_COMPLETIONS[mask] |= (uint16_t)(1 << cell);
+            }
+        }
+    }
+
+    for (size_t cell = 0; cell < ULTIMATE_CELLS; ++cell) {
+        ULTIMATE_ZOBRIST_KEYS[PLAYER_X][cell] = split_mix_64(&seed);
+        ULTIMATE_ZOBRIST_KEYS[PLAYER_O][cell] = split_mix_64(&seed);
+    }
+
+    for (size_t i = 0; i <= ULTIMATE_BOARDS; ++i) {
+        ULTIMATE_ZOBRIST_FORCED_BOARDS[i] = split_mix_64(&seed);
+    }
+
+    ULTIMATE_ZOBRIST_O_TO_MOVE = split_mix_64(&seed);
+}
+
+/*******************************************************************
+The Ultimate board: nine 3x3 sub-boards, each a 9-bit mask per 
+player, and the meta-board of the sub-boards won. The movement to
+the cell 'c' of a sub-board sends the opponent to the sub-board 'c'.
+Cells are numbered sub-board by sub-board: 'b * 9 + c'.
+*******************************************************************/
+typedef struct ultimate_board_t
+{
+    uint16_t marks[2][ULTIMATE_BOARDS]; // Indexed by the player color.
+    uint16_t won[2];      // The sub-boards won by each player.
+    uint16_t closed;      // The sub-boards won or full.
+    uint8_t forced_board; // Where to move, or ULTIMATE_ANY_BOARD.
+    uint64_t key;         // The Zobrist key of all of the above.
+} ultimate_board_t;
+
+static void ultimate_board_t_init(ultimate_board_t* board)
+{
+    memset(board, 0, sizeof(*board));
+    board->forced_board = ULTIMATE_ANY_BOARD;
+    board->key = ULTIMATE_ZOBRIST_FORCED_BOARDS[ULTIMATE_ANY_BOARD];
+}
+
+static uint16_t ultimate_board_t_empty_cells(const ultimate_board_t* board,
+                                             size_t sub_board)
+{
+    return (uint16_t)(~(board->marks[PLAYER_X][sub_board] | 
+                        board->marks[PLAYER_O][sub_board]) &
+                      ULTIMATE_FULL_BOARD);
+}
+
+/*******************************************************
+Returns the sub-boards where the next movement may go.
+*******************************************************/
+static uint16_t ultimate_board_t_playable_boards(
+    const ultimate_board_t* board)
+{
+    if (board->forced_board != ULTIMATE_ANY_BOARD) {
+        return (uint16_t)(1 << board->forced_board);
+    }
+
+    return (uint16_t)(~board->closed & ULTIMATE_FULL_BOARD);
+}
+
+static void ultimate_board_t_make_movement(ultimate_board_t* board,
+                                           size_t cell,
+                                           PlayerColor player_color)
+{
+    size_t sub_board = cell / 9;
+    uint16_t* marks = &board->marks[player_color][sub_board];
+
+    board->key ^= ULTIMATE_ZOBRIST_FORCED_BOARDS[board->forced_board] ^
+                  ULTIMATE_ZOBRIST_KEYS[player_color][cell];
+    *marks |= (uint16_t)(1 << (cell % 9));
+
+    if (ULTIMATE_WINS[*marks]) {
+        board->won[player_color] |= (uint16_t)(1 << sub_board);
+        board->closed |= (uint16_t)(1 << sub_board);
+    } else if (ultimate_board_t_empty_cells(board, sub_board) == 0) {
+        board->closed |= (uint16_t)(1 << sub_board);
+    }
+
+    board->forced_board = (board->closed >> (cell % 9) & 1) 
+        ? ULTIMATE_ANY_BOARD 
+        : (uint8_t)(cell % 9);
+    board->key ^= ULTIMATE_ZOBRIST_FORCED_BOARDS[board->forced_board];
+}
+
+/*************************
+Checks the winning status.
+*************************/
+static WinningStatus ultimate_board_t_get_winner_status(
+    const ultimate_board_t* board)
+{
+    if (ULTIMATE_WINS[board->won[PLAYER_X]]) {
+        return WIN_X;
+    }
+
+    if (ULTIMATE_WINS[board->won[PLAYER_O]]) {
+        return WIN_O;
+    }
+
+    return board->closed == ULTIMATE_FULL_BOARD ? WIN_TIE : WIN_NA;
+}
+
+/****************************************************************
+Rates the position for 'player_color' alone: the meta lines still
+open to them, the sub-boards won and the open sub-board lines.
+****************************************************************/
+static int ultimate_board_t_rate_player(const ultimate_board_t* board,
+                                        PlayerColor player_color)
+{
+    PlayerColor opponent_color = invert_player_color(player_color);
+    uint16_t won = board->won[player_color];
+    uint16_t blocked = board->closed & ~won;
+    int score = 0;
+
+    for (size_t i = 0; i < 8; ++i) {
+        if ((ULTIMATE_LINES[i] & blocked) == 0) {
+            score += ULTIMATE_META_LINE_WEIGHTS[
+                popcount64(ULTIMATE_LINES[i] & won)];
+        }
+    }
+
+    for (size_t sub_board = 0; sub_board < ULTIMATE_BOARDS; ++sub_board) {
+        if (won >> sub_board & 1) {
+            score += 25 * ULTIMATE_BOARD_WEIGHTS[sub_board];
+        } else if ((board->closed >> sub_board & 1) == 0) {
+            uint16_t own = board->marks[player_color][sub_board];
+            uint16_t opponent = board->marks[opponent_color][sub_board];
+
+            for (size_t i = 0; i < 8; ++i) {
+                if ((ULTIMATE_LINES[i] & opponent) == 0) {
+                    score += ULTIMATE_LINE_WEIGHTS[
+                        popcount64(ULTIMATE_LINES[i] & own)] * 
+                        ULTIMATE_BOARD_WEIGHTS[sub_board];
+                }
+            }
+        }
+    }
+
+    return score;
+}
+
+/**********************************************************
+Evaluates the board from the point of view of 'player_color'.
+**********************************************************/
+static int ultimate_board_t_evaluate(const ultimate_board_t* board,
+                                     PlayerColor player_color)
+{
+    return ultimate_board_t_rate_player(board, player_color) -
+           ultimate_board_t_rate_player(board, 
+                                        invert_player_color(player_color));
+}
+
+/*******************************************************************
+Rates a movement of 'player_color' to 'cell' for the move ordering:
+winning the game or a sub-board first, then blocking a sub-board of
+the opponent, minus where the opponent gets sent to: a free choice of
+the sub-board or a sub-board they can win at once.
+*******************************************************************/
+static int ultimate_board_t_rate_movement(const ultimate_board_t* board,
+                                          PlayerColor player_color,
+                                          size_t cell)
+{
+    PlayerColor opponent_color = invert_player_color(player_color);
+    size_t sub_board = cell / 9;
+    size_t target = cell % 9;
+    uint16_t bit = (uint16_t)(1 << target);
+    uint16_t own = board->marks[player_color][sub_board];
+    uint16_t opponent = board->marks[opponent_color][sub_board];
+    int rating = ULTIMATE_BOARD_WEIGHTS[target];
+
+    if (ULTIMATE_COMPLETIONS[own] & bit) {
+        uint16_t won = board->won[player_color] | (uint16_t)(1 << sub_board);
+        rating += ULTIMATE_WINS[won] ? 1 << 20 : 
+                  4096 * ULTIMATE_BOARD_WEIGHTS[sub_board];
+    } else if (ULTIMATE_COMPLETIONS[opponent] & bit) {
+        rating += 1024 * ULTIMATE_BOARD_WEIGHTS[sub_board];
+    }
+
+    if ((board->closed >> target & 1) || 
+        (target == sub_board && (own | opponent | bit) == ULTIMATE_FULL_BOARD)) {
+        rating -= 2048;
+    } else if (ULTIMATE_COMPLETIONS[board->marks[opponent_color][target]] & 
+               ultimate_board_t_empty_cells(board, target) &
+               (target == sub_board ? (uint16_t)~bit : ULTIMATE_FULL_BOARD)) {
+        rating -= 1024 * ULTIMATE_BOARD_WEIGHTS[target];
+    }
+
+    return rating;
+}
+
+/*******************************************************************
+The Ultimate search: an iteratively deepened alpha-beta search with
+an evaluation at the horizon, a transposition table and a history
+heuristic, stopping when the time budget of the move runs out.
+*******************************************************************/
+typedef struct ultimate_engine_t
+{
+    transposition_table_t table;
+    uint32_t history[2][ULTIMATE_CELLS];
+    bool use_history;
+    uint32_t time_budget;      // Milliseconds per move.
+    int max_depth;
+    uint64_t deadline;         // micros() at which the search stops.
+    bool stopped;
+    search_context_t* context; // The context of the current search.
+} ultimate_engine_t;
+
+/*******************************************************************
+Applies the settings and allocates the transposition table. Returns
+false if out of memory.
+*******************************************************************/
+static bool ultimate_engine_t_init(ultimate_engine_t* engine,
+                                   const engine_settings_t* settings)
+{
+    engine->time_budget = settings->time_budget != 0 
+        ? settings->time_budget 
+        : ULTIMATE_DEFAULT_TIME_BUDGET;
+    engine->max_depth = settings->max_depth != 0 
+        ? (int)MIN(settings->max_depth, SEARCH_MAX_PLY) 
+        : SEARCH_MAX_PLY;
+    engine->use_history = !settings->no_history;
+    memset(engine->history, 0, sizeof(engine->history));
+    return transposition_table_t_init(&engine->table, 
+                                      settings->table_bits != 0 
+                                          ? settings->table_bits 
+                                          : ULTIMATE_TABLE_BITS);
+}
+
+static void ultimate_engine_t_free(ultimate_engine_t* engine)
+{
+    transposition_table_t_free(&engine->table);
+}
+
+/****************************************************
+Starts the search of the next movement of the game.
+****************************************************/
+static void ultimate_engine_t_age(ultimate_engine_t* engine)
+{
+    age_search_tables(&engine->table, engine->history[0], ULTIMATE_CELLS);
+}
+
+/*******************************************************************
+Lists the legal movements of 'player_color', rated for the move
+ordering. Returns the number of the movements.
+*******************************************************************/
+static size_t ultimate_engine_t_generate_movements(
+    ultimate_engine_t* engine,
+    const ultimate_board_t* board,
+    PlayerColor player_color,
+    int table_movement,
+    uint8_t* movements,
+    int* ratings)
+{
+    uint16_t boards = ultimate_board_t_playable_boards(board);
+    size_t count = 0;
+
+    while (boards != 0) {
+        size_t sub_board = bit_scan_forward64(boards);
+        uint16_t empty = ultimate_board_t_empty_cells(board, sub_board);
+        boards &= boards - 1;
+
+        while (empty != 0) {
+            size_t cell = sub_board * 9 + bit_scan_forward64(empty);
+            empty &= empty - 1;
+
+            movements[count] = (uint8_t)cell;
+            ratings[count] = (int)cell == table_movement 
+                ? POSITIVE_INFINITY
+                : ultimate_board_t_rate_movement(board, player_color, cell) +
+                  (engine->use_history 
+                      ? (int)MIN(engine->history[player_color][cell], 1u << 16)
+                      : 0);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*******************************************************************
+Searches the board with 'player_color' to move 'depth' plies deep,
+returning the score from the point of view of 'player_color'. 'ply'
+is the distance from the root.
+*******************************************************************/
+static int ultimate_engine_t_search(ultimate_engine_t* engine,
+                                    const ultimate_board_t* board,
+                                    PlayerColor player_color,
+                                    int depth,
+                                    int ply,
+                                    int alpha,
+                                    int beta)
+{
+    search_context_t* context = engine->context;
+    PlayerColor opponent_color = invert_player_color(player_color);
+
+    context->nodes++;
+    TELEMETRY(context->telemetry.nodes_per_depth[
+                  MIN(ply, TELEMETRY_MAX_DEPTH - 1)]++);
+
+    if ((context->nodes & 1023) == 0 && micros() >= engine->deadline) {
+        engine->stopped = true;
+    }
+
+    if (engine->stopped) {
+        return 0;
+    }
+
+    if (ULTIMATE_WINS[board->won[opponent_color]]) {
+        return -(SEARCH_WIN_SCORE - ply);
+    }
+
+    if (board->closed == ULTIMATE_FULL_BOARD) {
+        return 0;
+    }
+
+    if (depth <= 0) {
+        return ultimate_board_t_evaluate(board, player_color);
+    }
+
+    uint64_t key = board->key ^ 
+        (player_color == PLAYER_O ? ULTIMATE_ZOBRIST_O_TO_MOVE : 0);
+    const table_entry_t* entry = 
+        transposition_table_t_probe(&engine->table, key, context);
+    int table_movement = entry != NULL ? entry->movement : -1;
+    int table_score;
+
+    if (entry != NULL && 
+        table_entry_t_cuts_off(entry, depth, ply, alpha, beta, &table_score)) {
+        return table_score;
+    }
+
+    uint8_t movements[ULTIMATE_CELLS];
+    int ratings[ULTIMATE_CELLS];
+    size_t count = ultimate_engine_t_generate_movements(engine,
+                                                        board,
+                                                        player_color,
+                                                        table_movement,
+                                                        movements,
+                                                        ratings);
+    int original_alpha = alpha;
+    int best_score = NEGATIVE_INFINITY;
+    size_t best_movement = movements[0];
+
+    for (size_t i = 0; i < count; ++i) {
+        select_movement(movements, ratings, i, count);
+
+        ultimate_board_t child = *board;
+        ultimate_board_t_make_movement(&child, movements[i], player_color);
+
+        int score = -ultimate_engine_t_search(engine,
+                                              &child,
+                                              opponent_color,
+                                              depth - 1,
+                                              ply + 1,
+                                              -beta,
+                                              -alpha);
+        if (engine->stopped) {
+            return 0;
+        }
+
+        if (score > best_score) {
+            best_score = score;
+            best_movement = movements[i];
+        }
+
+        alpha = MAX(alpha, score);
+
+        if (alpha >= beta) {
+            engine->history[player_color][movements[i]] += 
+                (uint32_t)(depth * depth);
+            TELEMETRY(context->telemetry.cutoffs_per_index[i]++);
+            break;
+        }
+    }
+
+    transposition_table_t_store(&engine->table,
+                                key,
+                                depth,
+                                ply,
+                                best_score,
+                                original_alpha,
+                                beta,
+                                best_movement);
+    return best_score;
+}
+
+/*******************************************************************
+Finds the best movement of 'player_color' within the time budget.
+The score of the movement is stored in 'score'; positive scores favor
+O, negative ones favor X.
+*******************************************************************/
+static size_t ultimate_engine_t_compute_movement(ultimate_engine_t* engine,
+                                                 const ultimate_board_t* board,
+                                                 PlayerColor player_color,
+                                                 search_context_t* context,
+                                                 int* score)
+{
+    PlayerColor opponent_color = invert_player_color(player_color);
+    uint64_t search_start = micros();
+    uint8_t movements[ULTIMATE_CELLS];
+    int ratings[ULTIMATE_CELLS];
+    size_t best_movement;
+    int best_score = 0;
+
+    engine->context = context;
+    engine->deadline = search_start + (uint64_t)engine->time_budget * 1000;
+    engine->stopped = false;
+    ultimate_engine_t_age(engine);
+
+    const table_entry_t* entry = transposition_table_t_probe(
+        &engine->table,
+        board->key ^ 
+            (player_color == PLAYER_O ? ULTIMATE_ZOBRIST_O_TO_MOVE : 0),
+        context);
+    size_t count = ultimate_engine_t_generate_movements(
+        engine,
+        board,
+        player_color,
+        entry != NULL ? entry->movement : -1,
+        movements,
+        ratings);
+    select_movement(movements, ratings, 0, count);
+    best_movement = movements[0];
+
+    for (int depth = 1; depth <= engine->max_depth && count > 1; ++depth) {
+        TELEMETRY(uint64_t iteration_start = micros());
+        int alpha = NEGATIVE_INFINITY;
+        size_t iteration_best_movement = best_movement;
+        size_t searched = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            // Search the best movement so far first, then the rest
+            // in the order of their ratings.
+            if (i == 0) {
+                ratings[0] = POSITIVE_INFINITY;
+            } else {
+                select_movement(movements, ratings, i, count);
+            }
+
+            ultimate_board_t child = *board;
+            ultimate_board_t_make_movement(&child, movements[i], player_color);
+
+            int tentative_score = -ultimate_engine_t_search(engine,
+                                                            &child,
+                                                            opponent_color,
+                                                            depth - 1,
+                                                            1,
+                                                            NEGATIVE_INFINITY,
+                                                            -alpha);
+            if (engine->stopped) {
+                break;
+            }
+
+            searched++;
+            ratings[i] = tentative_score;
+
+            if (tentative_score > alpha) {
+                alpha = tentative_score;
+                iteration_best_movement = movements[i];
+            }
+        }
+
+        if (searched > 0) {
+            best_movement = iteration_best_movement;
+            best_score = alpha;
+        }
+
+        // Put the best movement in front for the next iteration.
+        for (size_t i = 0; i < count; ++i) {
+            if (movements[i] == best_movement) {
+                ratings[i] = ratings[0];
+                movements[i] = movements[0];
+                movements[0] = (uint8_t)best_movement;
+                break;
+            }
+        }
+
+#if SEARCH_TELEMETRY
+        search_telemetry_t* telemetry = &context->telemetry;
+
+        if (telemetry->number_of_iterations < TELEMETRY_MAX_ITERATIONS) {
+            telemetry->iteration_micros[telemetry->number_of_iterations++] =
+                micros() - iteration_start;
+        }
+
+        search_context_t_trace(context, "iteration", iteration_start);
+#endif
+
+        if (engine->stopped || 
+            best_score > SEARCH_WIN_THRESHOLD ||
+            best_score < -SEARCH_WIN_THRESHOLD) {
+            break;
+        }
+    }
+
+    TELEMETRY(search_context_t_trace(context, "search", search_start));
+    *score = player_color == PLAYER_O ? best_score : -best_score;
+    return best_movement;
+}
+
+/*******************************************************************
+Converts the sub-board-by-sub-board cell numbering of the Ultimate
+board to and from the row-by-row numbering of the 9x9 grid.
+*******************************************************************/
+static size_t ultimate_cell_to_grid_cell(size_t cell)
+{
+    size_t sub_board = cell / 9;
+    size_t x = (sub_board % 3) * 3 + cell % 9 % 3;
+    size_t y = (sub_board / 3) * 3 + cell % 9 / 3;
+    return y * 9 + x;
+}
+
+static size_t ultimate_grid_cell_to_cell(size_t grid_cell)
+{
+    size_t x = grid_cell % 9;
+    size_t y = grid_cell / 9;
+    return ((y / 3) * 3 + x / 3) * 9 + (y % 3) * 3 + x % 3;
+}
+
+#define ULTIMATE_SUB_BOARD_SPRITE_WIDTH 11
+#define ULTIMATE_SUB_BOARD_SPRITE_HEIGHT 5
+#define ULTIMATE_SPRITE_WIDTH (3 * (ULTIMATE_SUB_BOARD_SPRITE_WIDTH + 1) + 1)
+#define ULTIMATE_SPRITE_HEIGHT (3 * (ULTIMATE_SUB_BOARD_SPRITE_HEIGHT + 1) + 1)
+
+/*******************************************************************
+Prints the board like the 3x3 one, each cell holding a sub-board
+and the sub-board numbers on the top borders. The empty cells where
+the next movement may go show their numbers; the won sub-boards show
+the cell sprite of the winner.
+*******************************************************************/
+static void ultimate_board_t_print(const ultimate_board_t* board)
+{
+    char sprite[ULTIMATE_SPRITE_HEIGHT][ULTIMATE_SPRITE_WIDTH + 1];
+    uint16_t playable = 
+        board->closed == ULTIMATE_FULL_BOARD ||
+        ULTIMATE_WINS[board->won[PLAYER_X]] ||
+        ULTIMATE_WINS[board->won[PLAYER_O]] 
+            ? 0 
+            : ultimate_board_t_playable_boards(board);
+
+    for (size_t y = 0; y < ULTIMATE_SPRITE_HEIGHT; ++y) {
+        for (size_t x = 0; x < ULTIMATE_SPRITE_WIDTH; ++x) {
+            bool horizontal = y % (ULTIMATE_SUB_BOARD_SPRITE_HEIGHT + 1) == 0;
+            bool vertical = x % (ULTIMATE_SUB_BOARD_SPRITE_WIDTH + 1) == 0;
+
+            sprite[y][x] = horizontal && vertical ? '+' :
+                           horizontal ? '-' :
+                           vertical ? '|' : ' ';
+        }
+
+        sprite[y][ULTIMATE_SPRITE_WIDTH] = '\0';
+    }
+
+    for (size_t sub_board = 0; sub_board < ULTIMATE_BOARDS; ++sub_board) {
+        size_t origin_x = 
+            (sub_board % 3) * (ULTIMATE_SUB_BOARD_SPRITE_WIDTH + 1) + 1;
+        size_t origin_y = 
+            (sub_board / 3) * (ULTIMATE_SUB_BOARD_SPRITE_HEIGHT + 1) + 1;
+
+        sprite[origin_y - 1][origin_x + ULTIMATE_SUB_BOARD_SPRITE_WIDTH / 2] =
+            (char)('1' + sub_board);
+
+        if ((board->won[PLAYER_X] | board->won[PLAYER_O]) >> sub_board & 1) {
+            bool won_by_x = board->won[PLAYER_X] >> sub_board & 1;
+
+            for (size_t y = 0; y < BOARD_CELL_SPRITE_HEIGHT; ++y) {
+                for (size_t x = 0; x < BOARD_CELL_SPRITE_WIDTH; ++x) {
+                    sprite[origin_y + 1 + y][origin_x + 2 + x] = won_by_x 
+                        ? BOARD_X_SPRITE[y][x] 
+                        : BOARD_O_SPRITE[y][x];
+                }
+            }
+
+            continue;
+        }
+
+        for (size_t cell = 0; cell < 9; ++cell) {
+            size_t x = origin_x + (cell % 3) * 4;
+            size_t y = origin_y + (cell / 3) * 2;
+            char mark = 
+                board->marks[PLAYER_X][sub_board] >> cell & 1 ? 'X' :
+                board->marks[PLAYER_O][sub_board] >> cell & 1 ? 'O' :
+                playable >> sub_board & 1 ? (char)('1' + cell) : ' ';
+
+            sprite[y][x + 1] = mark;
+
+            if (cell % 3 != 2) {
+                sprite[y][x + 3] = '|';
+            }
+
+            if (cell / 3 != 2) {
+                memcpy(&sprite[y + 1][x], cell % 3 != 2 ? "---+" : "---", 
+                       cell % 3 != 2 ? 4 : 3);
+            }
+        }
+    }
+
+    for (size_t y = 0; y < ULTIMATE_SPRITE_HEIGHT; ++y) {
+        puts(sprite[y]);
+    }
+}
+
+/*******************************************************************
+Reads a movement from the user as the sub-board and the cell, both
+from 1 to 9, or just the cell when the sub-board is forced. Returns
+false on the end of the input.
+*******************************************************************/
+static bool ultimate_board_t_read_movement(const ultimate_board_t* board,
+                                           size_t* cell)
+{
+    uint16_t playable = ultimate_board_t_playable_boards(board);
+    char line[64];
+
+    while (true) {
+        unsigned sub_board, sub_board_cell;
+        char trailing;
+
+        if (board->forced_board != ULTIMATE_ANY_BOARD) {
+            printf("Please enter your desired move (cell in board %u): ",
+                   (unsigned)board->forced_board + 1);
+        } else {
+            printf("Please enter your desired move (board cell): ");
+        }
+
+        if (fgets(line, sizeof(line), stdin) == NULL) {
+            return false;
+        }
+
+        int count = sscanf(line, 
+                           "%u %u %c", 
+                           &sub_board, 
+                           &sub_board_cell, 
+                           &trailing);
+
+        if (count == 1 && board->forced_board != ULTIMATE_ANY_BOARD) {
+            sub_board_cell = sub_board;
+            sub_board = board->forced_board + 1u;
+        } else if (count != 2) {
+            continue;
+        }
+
+        if (sub_board < 1 || sub_board > 9 || 
+            sub_board_cell < 1 || sub_board_cell > 9 ||
+            (playable >> (sub_board - 1) & 1) == 0 ||
+            (ultimate_board_t_empty_cells(board, sub_board - 1) >> 
+             (sub_board_cell - 1) & 1) == 0) {
+            continue;
+        }
+
+        *cell = (sub_board - 1) * 9 + sub_board_cell - 1;
+        return true;
+    }
+}
+
+/*******************************
+Generates a random player color.
+*******************************/
+static PlayerColor generate_random_player_color()
+{
+    return rand() % 2 == 0 ? PLAYER_X : PLAYER_O;
+}
+
+/*******************************************************************
+The operations the game loop needs from a game variant. A game is
+an opaque pointer created by 'create_game'; cells are numbered from
+0 in the order of the cell numbers shown to the user.
+*******************************************************************/
+typedef struct game_variant_t
+{
+    const char* name;
+
+    // The board geometry as stored in the game records.
+    uint8_t width;
+    uint8_t height;
+    uint8_t layers;
+    uint8_t row_length;
+
+    // The ENGINE_SETTING_* bits of the settings the engine honors.
+    uint8_t engine_settings;
+
+    // Creates a game with an empty board and an engine with the
+    // settings; NULL if out of memory.
+    void* (*create_game)(const engine_settings_t* settings);
+    void (*free_game)(void* game);
+    void (*print)(void* game);
+
+    // Prompts the user for a movement until it is a valid one.
+    // Returns false on the end of the input.
+    bool (*read_human_movement)(void* game, size_t* cell);
+
+    // Returns the AI movement; the score favors O if positive.
+    size_t (*compute_ai_movement)(void* game,
+                                  PlayerColor player_color,
+                                  search_context_t* context,
+                                  int* score);
+    void (*make_movement)(void* game, 
+                          size_t cell, 
+                          PlayerColor player_color);
+    WinningStatus (*get_winner_status)(void* game);
+
+    // Stores the legal movements to 'cells', returning their number.
+    size_t (*list_movements)(void* game, size_t* cells);
+} game_variant_t;
+
+/*******************************************************************
+A game on the 3x3 board. The board is always searched to the end, so
+the preference filter is the only setting that matters.
+*******************************************************************/
+typedef struct classic_game_t
+{
+    board_t board;
+    int preference_filter[HEIGHT][WIDTH];
+} classic_game_t;
+
+static void* classic_create_game(const engine_settings_t* settings)
+{
+    classic_game_t* game = malloc(sizeof(*game));
+
+    if (game != NULL) {
+        board_t_set_initial_cell_values(&game->board);
+        memcpy(game->preference_filter,
+               settings->has_preference_filter 
+                   ? settings->preference_filter 
+                   : PREFERENCE_FILTER,
+               sizeof(game->preference_filter));
+    }
+
+    return game;
+}
+
+static void classic_free_game(void* game)
+{
+    board_t_free(&((classic_game_t*)game)->board);
+    free(game);
+}
+
+static void classic_print(void* game)
+{
+    board_t_print(&((classic_game_t*)game)->board);
+}
+
+/*******************************************************************
+Prints the movements of 'player_color' ranked by the root analysis,
+each with its outcome and the expected continuation.
+*******************************************************************/
+static void print_movement_hints(board_t* board,
+                                 PlayerColor player_color,
+                                 const int preference_filter[HEIGHT][WIDTH])
+{
+    root_line_t lines[ROOT_ANALYSIS_CELLS];
+    search_context_t context = { 0 };
+    size_t count = analyze_root_movements(board,
+                                          player_color,
+                                          preference_filter,
+                                          ROOT_ANALYSIS_CELLS,
+                                          lines,
+                                          &context);
+
+    for (size_t i = 0; i < count; ++i) {
+        int score = player_color == PLAYER_O ? lines[i].score 
+                                             : -lines[i].score;
+        int moves = ROOT_ANALYSIS_WIN_SCORE + 1 - abs(score);
+        char outcome[32];
+
+        if (score == 0) {
+            snprintf(outcome, sizeof(outcome), "draw");
+        } else {
+            snprintf(outcome, 
+                     sizeof(outcome), 
+                     "%s in %d moves", 
+                     score > 0 ? "win" : "loss", 
+                     moves);
+        }
+
+        printf("  %d: %-16s", lines[i].pv[0] + 1, outcome);
+
+        for (size_t j = 0; j < lines[i].pv_length; ++j) {
+            printf(" %d", lines[i].pv[j] + 1);
+        }
+
+        puts("");
+    }
+}
+
+static bool classic_read_human_movement(void* game, size_t* cell)
+{
+    classic_game_t* classic_game = game;
+    board_t* board = &classic_game->board;
+    movement_t desired_movement;
+    desired_movement.x = WIDTH;
+    desired_movement.y = HEIGHT;
+
+    do
+    {
+        printf("Please enter your desired move ('?' for hints): ");
+
+        fflush(stdin);
+
+        char position_choice;
+
+        if (scanf("%c", &position_choice) != 1) {
+            return false;
+        }
+
+        if (position_choice == '?') {
+            puts("");
+            print_movement_hints(board, 
+                                 PLAYER_X, 
+                                 classic_game->preference_filter);
+            continue;
+        }
+
+        if (!is_valid_position_character(position_choice)) {
+            puts("");
+            continue;
+        }
+
+        desired_movement = 
+            convert_board_selector_to_move(position_choice);
+
+    } while (!board_t_can_make_movement(board, desired_movement));
+
+    *cell = desired_movement.y * WIDTH + desired_movement.x;
+    return true;
+}
+
+static size_t classic_compute_ai_movement(void* game,
+                                          PlayerColor player_color,
+                                          search_context_t* context,
+                                          int* score)
+{
+    classic_game_t* classic_game = game;
+    movement_t movement = player_color == PLAYER_O 
+        ? compute_next_ai_movement(&classic_game->board, 
+                                   classic_game->preference_filter,
+                                   context, 
+                                   score)
+        : compute_best_movement(&classic_game->board, 
+                                player_color, 
+                                classic_game->preference_filter,
+                                context, 
+                                score);
+
+    return movement.y * WIDTH + movement.x;
+}
+
+static void classic_make_movement(void* game, 
+                                  size_t cell, 
+                                  PlayerColor player_color)
+{
+    movement_t movement = { cell % WIDTH, cell / WIDTH };
+
+    board_t_set_cell_color_via_movement(
+        &((classic_game_t*)game)->board,
+        movement,
+        player_color_to_board_cell_color(player_color));
+}
+
+static WinningStatus classic_get_winner_status(void* game)
+{
+    return board_t_get_winner_status(&((classic_game_t*)game)->board);
+}
+
+static size_t classic_list_movements(void* game, size_t* cells)
+{
+    board_t* board = &((classic_game_t*)game)->board;
+    size_t count = 0;
+
+    for (size_t cell = 0; cell < WIDTH * HEIGHT; ++cell) {
+        movement_t movement = { cell % WIDTH, cell / WIDTH };
+
+        if (board_t_can_make_movement(board, movement)) {
+            cells[count++] = cell;
+        }
+    }
+
+    return count;
+}
+
+/*****************************************
+The original 3x3 board, searched to the end.
+*****************************************/
+static const game_variant_t CLASSIC_VARIANT = {
+    "3x3",
+    WIDTH,
+    HEIGHT,
+    1,
+    3,
+    ENGINE_SETTING_PREFERENCES, // The search always runs to the end.
+    classic_create_game,
+    classic_free_game,
+    classic_print,
+    classic_read_human_movement,
+    classic_compute_ai_movement,
+    classic_make_movement,
+    classic_get_winner_status,
+    classic_list_movements,
+};
+
+/*******************************************
+A game of Qubic: the board and its engine.
+*******************************************/
+typedef struct qubic_game_t
+{
+    qubic_board_t board;
+    qubic_engine_t engine;
+} qubic_game_t;
+
+static void* qubic_create_game(const engine_settings_t* settings)
+{
+    qubic_game_t* game = calloc(1, sizeof(*game));
+
+    if (game == NULL) {
+        return NULL;
+    }
+
+    if (!qubic_engine_t_init(&game->engine, settings)) {
+        free(game);
+        return NULL;
+    }
+
+    return game;
+}
+
+static void qubic_free_game(void* game)
+{
+    qubic_engine_t_free(&((qubic_game_t*)game)->engine);
+    free(game);
+}
+
+static void qubic_print(void* game)
+{
+    qubic_board_t_print(&((qubic_game_t*)game)->board);
+}
+
+static bool qubic_read_human_movement(void* game, size_t* cell)
+{
+    return qubic_board_t_read_movement(&((qubic_game_t*)game)->board, cell);
+}
+
+static size_t qubic_compute_ai_movement(void* game,
+                                        PlayerColor player_color,
+                                        search_context_t* context,
+                                        int* score)
+{
+    qubic_game_t* qubic_game = game;
+
+    return qubic_engine_t_compute_movement(&qubic_game->engine,
+                                           &qubic_game->board,
+                                           player_color,
+                                           context,
+                                           score);
+}
+
+static void qubic_make_movement(void* game, 
+                                size_t cell, 
+                                PlayerColor player_color)
+{
+    qubic_board_t_toggle(&((qubic_game_t*)game)->board, cell, player_color);
+}
+
+static WinningStatus qubic_get_winner_status(void* game)
+{
+    return qubic_board_t_get_winner_status(&((qubic_game_t*)game)->board);
+}
+
+static size_t qubic_list_movements(void* game, size_t* cells)
+{
+    uint64_t empty = qubic_board_t_empty_cells(&((qubic_game_t*)game)->board);
+    size_t count = 0;
+
+    for (; empty != 0; empty &= empty - 1) {
+        cells[count++] = bit_scan_forward64(empty);
+    }
+
+    return count;
+}
+
+/*****************************************************
+3D tic-tac-toe on a 4x4x4 cube, four in a row to win.
+*****************************************************/
+static const game_variant_t QUBIC_VARIANT = {
+    "qubic",
+    QUBIC_SIZE,
+    QUBIC_SIZE,
+    QUBIC_SIZE,
+    QUBIC_SIZE,
+    ENGINE_SETTING_TIME | ENGINE_SETTING_DEPTH | 
+    ENGINE_SETTING_TABLE | ENGINE_SETTING_HISTORY,
+    qubic_create_game,
+    qubic_free_game,
+    qubic_print,
+    qubic_read_human_movement,
+    qubic_compute_ai_movement,
+    qubic_make_movement,
+    qubic_get_winner_status,
+    qubic_list_movements,
+};
+
+/*******************************************************************
+A game of Ultimate tic-tac-toe: the board and its engine. The cells
+seen by the game loop are numbered row by row on the 9x9 grid.
+*******************************************************************/
+typedef struct ultimate_game_t
+{
+    ultimate_board_t board;
+    ultimate_engine_t engine;
+} ultimate_game_t;
+
+static void* ultimate_create_game(const engine_settings_t* settings)
+{
+    ultimate_game_t* game = calloc(1, sizeof(*game));
+
+    if (game == NULL) {
+        return NULL;
+    }
+
+    if (!ultimate_engine_t_init(&game->engine, settings)) {
+        free(game);
+        return NULL;
+    }
+
+    ultimate_board_t_init(&game->board);
+    return game;
+}
+
+static void ultimate_free_game(void* game)
+{
+    ultimate_engine_t_free(&((ultimate_game_t*)game)->engine);
+    free(game);
+}
+
+static void ultimate_print(void* game)
+{
+    ultimate_board_t_print(&((ultimate_game_t*)game)->board);
+}
+
+static bool ultimate_read_human_movement(void* game, size_t* cell)
+{
+    size_t ultimate_cell;
+
+    if (!ultimate_board_t_read_movement(&((ultimate_game_t*)game)->board,
+                                        &ultimate_cell)) {
+        return false;
+    }
+
+    *cell = ultimate_cell_to_grid_cell(ultimate_cell);
+    return true;
+}
+
+static size_t ultimate_compute_ai_movement(void* game,
+                                           PlayerColor player_color,
+                                           search_context_t* context,
+                                           int* score)
+{
+    ultimate_game_t* ultimate_game = game;
+
+    return ultimate_cell_to_grid_cell(
+        ultimate_engine_t_compute_movement(&ultimate_game->engine,
+                                           &ultimate_game->board,
+                                           player_color,
+                                           context,
+                                           score));
+}
+
+static void ultimate_make_movement(void* game,
+                                   size_t cell,
+                                   PlayerColor player_color)
+{
+    ultimate_board_t_make_movement(&((ultimate_game_t*)game)->board,
+                                   ultimate_grid_cell_to_cell(cell),
+                                   player_color);
+}
+
+static WinningStatus ultimate_get_winner_status(void* game)
+{
+    return ultimate_board_t_get_winner_status(
+        &((ultimate_game_t*)game)->board);
+}
+
+static size_t ultimate_list_movements(void* game, size_t* cells)
+{
+    const ultimate_board_t* board = &((ultimate_game_t*)game)->board;
+    size_t count = 0;
+
+    if (ultimate_board_t_get_winner_status(board) != WIN_NA) {
+        return 0;
+    }
+
+    for (uint16_t boards = ultimate_board_t_playable_boards(board);
+         boards != 0;
+         boards &= boards - 1) {
+        size_t sub_board = bit_scan_forward64(boards);
+
+        for (uint16_t empty = ultimate_board_t_empty_cells(board, sub_board);
+             empty != 0;
+             empty &= empty - 1) {
+            cells[count++] = ultimate_cell_to_grid_cell(
+                sub_board * 9 + bit_scan_forward64(empty));
+        }
+    }
+
+    return count;
+}
+
+/*******************************************************************
+Nine 3x3 boards in a 3x3 grid: a movement sends the opponent to the
+sub-board matching its cell, and three sub-boards in a row win.
+*******************************************************************/
+static const game_variant_t ULTIMATE_VARIANT = {
+    "ultimate",
+    9,
+    9,
+    1,
+    3,
+    ENGINE_SETTING_TIME | ENGINE_SETTING_DEPTH | 
+    ENGINE_SETTING_TABLE | ENGINE_SETTING_HISTORY,
+    ultimate_create_game,
+    ultimate_free_game,
+    ultimate_print,
+    ultimate_read_human_movement,
+    ultimate_compute_ai_movement,
+    ultimate_make_movement,
+    ultimate_get_winner_status,
+    ultimate_list_movements,
+};
+
+static const game_variant_t* const GAME_VARIANTS[] = {
+    &CLASSIC_VARIANT,
+    &QUBIC_VARIANT,
+    &ULTIMATE_VARIANT,
+};
+
+/*****************************************************
+Returns the game variant called 'name' or NULL if none.
+*****************************************************/
+static const game_variant_t* find_game_variant(const wchar_t* name)
+{
+    for (size_t i = 0; 
+         i < sizeof(GAME_VARIANTS) / sizeof(GAME_VARIANTS[0]); 
+         ++i) {
+        const char* variant_name = GAME_VARIANTS[i]->name;
+        size_t j = 0;
+
+        while (variant_name[j] != '\0' && 
+               (wchar_t)variant_name[j] == name[j]) {
+            j++;
+        }
+
+        if (variant_name[j] == '\0' && name[j] == L'\0') {
+            return GAME_VARIANTS[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************
+Where a match against the bot leaves its traces. NULL members are
+not used.
+*******************************************************************/
+typedef struct play_options_t
+{
+    game_record_writer_t* record_writer;
+    FILE* telemetry_file;         // Receives a JSON line per AI move.
+    trace_writer_t* trace_writer; // Receives the AI search phases.
+    engine_settings_t engine_settings;
+} play_options_t;
+
+/**************************
+Runs a match against a bot.
+**************************/
+void bot_mode(const game_variant_t* variant, const play_options_t* options)
+{
+    game_record_writer_t* record_writer = options->record_writer;
+    size_t ply = 0;
+    void* game = variant->create_game(&options->engine_settings);
+
+    if (game == NULL) {
+        puts("Out of memory.");
+        return;
+    }
+
+    bool gameInProgress = true;
+    PlayerColor player_color = generate_random_player_color();
+
+    puts("Your mark is X, AI is O.");
+    variant->print(game);
+
+    if (record_writer != NULL) {
+        game_record_writer_t_begin_game(record_writer, player_color);
+    }
+
+    while (true) {
+        if (player_color == PLAYER_X) {
+            puts(">>> It's your turn.");
+        } else {
+            puts(">>> AI's turn.");
+        }
+
+        if (player_color == PLAYER_X) {
+            size_t desired_cell;
+            size_t duration = millis();
+
+            if (!variant->read_human_movement(game, &desired_cell)) {
+                puts("");
+                variant->free_game(game);
+                return;
+            }
+
+            duration = millis() - duration;
+
+            variant->make_movement(game, desired_cell, player_color);
+
+            if (record_writer != NULL) {
+                game_record_writer_t_add_move(record_writer,
+                                              desired_cell,
+                                              false,
+                                              0,
+                                              duration);
+            }
+
+        } else {
+            // This belongs to the AI.
+            search_context_t context = { 0 };
+            int score;
+#if SEARCH_TELEMETRY
+            context.trace_writer = options->trace_writer;
+#endif
+            uint64_t start = micros();
+            size_t best_cell = variant->compute_ai_movement(game,
+                                                            player_color,
+                                                            &context,
+                                                            &score);
+            uint64_t search_micros = micros() - start;
+            size_t duration = (size_t)(search_micros / 1000);
+
+            printf("AI duration: %zu milliseconds.\n", duration);
+
+            variant->make_movement(game, best_cell, player_color);
+
+            if (record_writer != NULL) {
+                game_record_writer_t_add_move(record_writer,
+                                              best_cell,
+                                              true,
+                                              score,
+                                              duration);
+            }
+
+#if SEARCH_TELEMETRY
+            if (options->telemetry_file != NULL) {
+                search_context_t_write_telemetry(&context,
+                                                 options->telemetry_file,
+                                                 ply,
+                                                 player_color,
+                                                 best_cell + 1,
+                                                 score,
+                                                 search_micros);
+            }
+#endif
+        }
+
+        variant->print(game);
+
+        WinningStatus winning_status = variant->get_winner_status(game);
+
+        if (winning_status == WIN_X) {
+            puts("You won!");
+            gameInProgress = false;
+        } else if (winning_status == WIN_O) {
+            puts("AI won.");
+            gameInProgress = false;
+        } else if (winning_status == WIN_TIE) {
+            puts("It's a tie.");
+            gameInProgress = false;
+        }
+
+        if (gameInProgress == false) {
+            if (record_writer != NULL) {
+                game_record_writer_t_end_game(record_writer, 
+                                              winning_status);
+            }
+
+            puts("");
+            variant->free_game(game);
+            return;
+        }
+
+        // Invert the player
+        player_color = invert_player_color(player_color);
+        ply++;
+    }
+}
+
+#define ANALYSIS_LINE_CAPACITY 128
+#define ANALYSIS_DEFAULT_CAPACITY 4096
+
+/*****************************************************************
+Converts a character of a compact board string to the color of the
+cell number 'index'. Returns false if 'ch' denotes no cell color. A
+digit denotes an empty cell only at the index it names.
+*****************************************************************/
+static bool board_string_character_to_cell_color(char ch,
+                                                 size_t index,
+                                                 BoardCellColor* color)
+{
+    switch (ch) {
+    case 'X':
+    case 'x':
+        *color = CELL_COLOR_X;
+        return true;
+
+    case 'O':
+    case 'o':
+        *color = CELL_COLOR_O;
+        return true;
+
+    case '.':
+    case '-':
+    case '_':
+        *color = (BoardCellColor)(CELL_COLOR_EMPTY_1 + index);
+        return true;
+
+    default:
+        if (is_valid_position_character(ch) && (size_t)(ch - '1') == index) {
+            *color = (BoardCellColor)(CELL_COLOR_EMPTY_1 + index);
+            return true;
+        }
+
+        return false;
+    }
+}
+
+/*******************************************************************
+Parses a compact board string such as "X.O..X..O", optionally
+followed by the side to move. When the side is omitted, the player
+with fewer marks moves; X moves if both have the same number.
+*******************************************************************/
+static bool parse_board_string(const char* text,
+                               board_t* board,
+                               PlayerColor* player_color)
+{
+    size_t x_count = 0;
+    size_t o_count = 0;
+
+    for (size_t i = 0; i < HEIGHT * WIDTH; ++i) {
+        BoardCellColor color;
+
+        if (!board_string_character_to_cell_color(text[i], i, &color)) {
+            return false;
+        }
+
+        if (color == CELL_COLOR_X) {
+            x_count++;
+        } else if (color == CELL_COLOR_O) {
+            o_count++;
+        }
+
+        board_t_set_cell_color(board, i % WIDTH, i / WIDTH, color);
+    }
+
+    if (x_count > o_count + 1 || o_count > x_count + 1) {
+        return false;
+    }
+
+    text += HEIGHT * WIDTH;
+
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+
+    if (*text == 'X' || *text == 'x') {
+        *player_color = PLAYER_X;
+        text++;
+    } else if (*text == 'O' || *text == 'o') {
+        *player_color = PLAYER_O;
+        text++;
+    } else {
+        *player_color = x_count > o_count ? PLAYER_O : PLAYER_X;
+    }
+
+    if ((x_count > o_count && *player_color != PLAYER_O) ||
+        (o_count > x_count && *player_color != PLAYER_X)) {
+        return false;
+    }
+
+    while (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n') {
+        text++;
+    }
+
+    return *text == '\0';
+}
+
+/*******************************************************************
+Parses a move list such as "5 1 9" or "519" played from the empty
+board, X moving first. Moves may be separated by spaces or commas.
+*******************************************************************/
+static bool parse_move_list(const char* text,
+                            board_t* board,
+                            PlayerColor* player_color)
+{
+    for (size_t i = 0; i < HEIGHT * WIDTH; ++i) {
+        board_t_set_cell_color(board,
+                               i % WIDTH,
+                               i / WIDTH,
+                               (BoardCellColor)(CELL_COLOR_EMPTY_1 + i));
+    }
+
+    *player_color = PLAYER_X;
+
+    for (; *text != '\0'; ++text) {
+        char ch = *text;
+
+        if (ch == ' ' || ch == ',' || ch == '\t' || 
+            ch == '\r' || ch == '\n') {
+            continue;
+        }
+
+        if (!is_valid_position_character(ch) ||
+            board_t_get_winner_status(board) != WIN_NA) {
+            return false;
+        }
+
+        movement_t movement = convert_board_selector_to_move(ch);
+
+        if (!board_t_can_make_movement(board, movement)) {
+            return false;
+        }
+
+        board_t_set_cell_color_via_movement(
+            board,
+            movement,
+            player_color_to_board_cell_color(*player_color));
+
+        *player_color = invert_player_color(*player_color);
+    }
+
+    return true;
+}
+
+/*******************************************************************
+Parses a single line of the batch input. Nine board characters in a
+row denote a board string, everything else is read as a move list.
+Nine digits alone are always a move list, since "123456789" is a
+whole game and not the empty board.
+*******************************************************************/
+static bool parse_position(const char* line,
+                           board_t* board,
+                           PlayerColor* player_color)
+{
+    size_t board_string_length = 0;
+    bool has_non_digit = false;
+    BoardCellColor color;
+
+    while (board_string_length <= HEIGHT * WIDTH &&
+           board_string_character_to_cell_color(line[board_string_length],
+                                                board_string_length,
+                                                &color)) {
+        if (!is_valid_position_character(line[board_string_length])) {
+            has_non_digit = true;
+        }
+
+        board_string_length++;
+    }
+
+    bool is_board_string = 
+        board_string_length == HEIGHT * WIDTH &&
+        has_non_digit &&
+        (line[board_string_length] == '\0' ||
+         line[board_string_length] == ' '  ||
+         line[board_string_length] == '\t' ||
+         line[board_string_length] == '\r' ||
+         line[board_string_length] == '\n');
+
+    if (is_board_string) {
+        return parse_board_string(line, board, player_color);
+    }
+
+    return parse_move_list(line, board, player_color);
+}
+
+/*****************************************************************
+A single position travelling through the analysis pipeline. Slots
+are reused in a ring, so the pipeline never holds more positions
+than there are slots.
+*****************************************************************/
+typedef struct analysis_slot_t
+{
+    board_t board;
+    PlayerColor player_color;
+    bool valid;
+    bool solved;
+    WinningStatus winning_status;
+    movement_t movement;
+    int score;
+    size_t number_of_lines;   // Ranked movements found, 0 unless asked.
+    root_line_t lines[ROOT_ANALYSIS_CELLS];
+    uint64_t micros;          // Duration of the search.
+    search_context_t context; // The context of the search.
+} analysis_slot_t;
+
+/*******************************************************************
+The parser, the solvers and the writer of the batch analysis. Line
+number 'i' lives in 'slots[i % capacity]'. The parser may run at
+most 'capacity' lines ahead of the writer; the solvers claim parsed
+lines in input order and the writer emits them in the same order.
+*******************************************************************/
+typedef struct analysis_pipeline_t
+{
+    FILE* input;
+    FILE* output;
+    FILE* telemetry_file;         // NULL unless writing telemetry.
+    trace_writer_t* trace_writer; // NULL unless tracing.
+    analysis_slot_t* slots;
+    size_t capacity;
+    size_t number_of_lines; // Ranked movements per position, 0 for none.
+    size_t parsed;  // Number of lines parsed so far.
+    size_t claimed; // Number of lines claimed by the solvers so far.
+    size_t written; // Number of lines written so far.
+    bool input_exhausted;
+    mutex_t mutex;
+    condition_t slot_released;
+    condition_t line_parsed;
+    condition_t line_solved;
+} analysis_pipeline_t;
+
+/*****************************************
+A solver thread of the analysis pipeline.
+*****************************************/
+typedef struct analysis_solver_t
+{
+    thread_t thread;
+    analysis_pipeline_t* pipeline;
+    size_t thread_id; // The thread in the trace.
+} analysis_solver_t;
+
+#define ANALYSIS_WRITER_THREAD_ID 0
+#define ANALYSIS_PARSER_THREAD_ID 1
+#define ANALYSIS_FIRST_SOLVER_THREAD_ID 2
+
+/*******************************************************************
+Reads the next non-blank, non-comment ('#') line into 'line'. Lines
+too long for the buffer are consumed entirely and reported as
+truncated. Returns false on the end of the input.
+*******************************************************************/
+static bool read_analysis_line(FILE* input,
+                               char line[ANALYSIS_LINE_CAPACITY],
+                               bool* truncated)
+{
+    while (fgets(line, ANALYSIS_LINE_CAPACITY, input)) {
+        size_t length = strlen(line);
+        *truncated = length == ANALYSIS_LINE_CAPACITY - 1 
+                  && line[length - 1] != '\n'
+                  && !feof(input);
+
+        if (*truncated) {
+            int ch;
+
+            while ((ch = fgetc(input)) != EOF && ch != '\n') {
+                // Skip the rest of the line.
+            }
+        }
+
+        const char* text = line;
+
+        while (*text == ' ' || *text == '\t') {
+            text++;
+        }
+
+        if (*text != '\0' && *text != '\n' && *text != '\r' && 
+            *text != '#') {
+            memmove(line, text, strlen(text) + 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************
+Reads and parses the input lines into free pipeline slots.
+******************************************************/
+static void analysis_parser_routine(void* argument)
+{
+    analysis_pipeline_t* pipeline = argument;
+    char line[ANALYSIS_LINE_CAPACITY];
+    bool truncated;
+
+    while (read_analysis_line(pipeline->input, line, &truncated)) {
+        mutex_t_lock(&pipeline->mutex);
+
+        while (pipeline->parsed - pipeline->written >= pipeline->capacity) {
+            condition_t_wait(&pipeline->slot_released, &pipeline->mutex);
+        }
+
+        analysis_slot_t* slot = 
+            &pipeline->slots[pipeline->parsed % pipeline->capacity];
+
+        mutex_t_unlock(&pipeline->mutex);
+        TELEMETRY(uint64_t start = micros());
+
+        // Nobody else touches the slot until 'parsed' is incremented.
+        slot->valid = !truncated && parse_position(line,
+                                                   &slot->board,
+                                                   &slot->player_color);
+        slot->solved = false;
+
+#if SEARCH_TELEMETRY
+        if (pipeline->trace_writer != NULL) {
+            trace_writer_t_add_event(pipeline->trace_writer,
+                                     "parse",
+                                     ANALYSIS_PARSER_THREAD_ID,
+                                     start,
+                                     micros());
+        }
+#endif
+
+        mutex_t_lock(&pipeline->mutex);
+        pipeline->parsed++;
+        condition_t_broadcast(&pipeline->line_parsed);
+        mutex_t_unlock(&pipeline->mutex);
+    }
+
+    mutex_t_lock(&pipeline->mutex);
+    pipeline->input_exhausted = true;
+    condition_t_broadcast(&pipeline->line_parsed);
+    condition_t_broadcast(&pipeline->line_solved);
+    mutex_t_unlock(&pipeline->mutex);
+}
+
+/*********************************************
+Runs the engine on the position of the slot.
+*********************************************/
+static void analysis_slot_t_solve(analysis_slot_t* slot,
+                                  size_t number_of_lines,
+                                  trace_writer_t* trace_writer,
+                                  size_t thread_id)
+{
+    search_context_t* context = &slot->context;
+    uint64_t start = micros();
+
+    memset(context, 0, sizeof(*context));
+    slot->number_of_lines = 0;
+#if SEARCH_TELEMETRY
+    context->trace_writer = trace_writer;
+    context->thread_id = thread_id;
+#else
+    (void)trace_writer;
+    (void)thread_id;
+#endif
+
+    if (!slot->valid) {
+        return;
+    }
+
+    slot->winning_status = board_t_get_winner_status(&slot->board);
+
+    switch (slot->winning_status) {
+    case WIN_X:
+        slot->score = -100;
+        break;
+
+    case WIN_O:
+        slot->score = 100;
+        break;
+
+    case WIN_TIE:
+        slot->score = 0;
+        break;
+
+    default:
+        if (number_of_lines == 0) {
+            slot->movement = compute_best_movement(&slot->board,
+                                                   slot->player_color,
+                                                   PREFERENCE_FILTER,
+                                                   context,
+                                                   &slot->score);
+            break;
+        }
+
+        slot->number_of_lines = analyze_root_movements(&slot->board,
+                                                       slot->player_color,
+                                                       PREFERENCE_FILTER,
+                                                       number_of_lines,
+                                                       slot->lines,
+                                                       context);
+        slot->movement = slot->lines[0].movement;
+        slot->score = slot->lines[0].score;
+        break;
+    }
+
+    slot->micros = micros() - start;
+}
+
+/*****************************************************
+Claims parsed lines in input order and solves them.
+*****************************************************/
+static void analysis_solver_routine(void* argument)
+{
+    analysis_solver_t* solver = argument;
+    analysis_pipeline_t* pipeline = solver->pipeline;
+
+    while (true) {
+        mutex_t_lock(&pipeline->mutex);
+
+        while (pipeline->claimed == pipeline->parsed && 
+               !pipeline->input_exhausted) {
+            condition_t_wait(&pipeline->line_parsed, &pipeline->mutex);
+        }
+
+        if (pipeline->claimed == pipeline->parsed) {
+            mutex_t_unlock(&pipeline->mutex);
+            return;
+        }
+
+        analysis_slot_t* slot = 
+            &pipeline->slots[pipeline->claimed++ % pipeline->capacity];
+
+        mutex_t_unlock(&pipeline->mutex);
+
+        analysis_slot_t_solve(slot, 
+                              pipeline->number_of_lines,
+                              pipeline->trace_writer, 
+                              solver->thread_id);
+
+        mutex_t_lock(&pipeline->mutex);
+        slot->solved = true;
+        condition_t_broadcast(&pipeline->line_solved);
+        mutex_t_unlock(&pipeline->mutex);
+    }
+}
+
+/***************************************************************
+Writes the analysis of the line number 'index': the best move 
+(1-9), the score from the point of view of O and the number of
+nodes, followed by the ranked movements if asked, each as " |" and
+the score and the principal variation, e.g. "5 0 769 | 0 5 1 9 ...".
+Finished games report '-' as the move, invalid lines "invalid". The
+telemetry of the search goes to 'telemetry_file' unless it is NULL.
+***************************************************************/
+static void analysis_slot_t_write(analysis_slot_t* slot,
+                                  size_t index,
+                                  FILE* output,
+                                  FILE* telemetry_file)
+{
+#if SEARCH_TELEMETRY
+    if (telemetry_file != NULL && 
+        slot->valid && 
+        slot->winning_status == WIN_NA) {
+        search_context_t_write_telemetry(&slot->context,
+                                         telemetry_file,
+                                         index,
+                                         slot->player_color,
+                                         slot->movement.y * WIDTH + 
+                                         slot->movement.x + 1,
+                                         slot->score,
+                                         slot->micros);
+    }
+#else
+    (void)index;
+    (void)telemetry_file;
+#endif
+
+    if (!slot->valid) {
+        fputs("invalid\n", output);
+    } else if (slot->winning_status != WIN_NA) {
+        fprintf(output, "- %d 0\n", slot->score);
+    } else {
+        fprintf(output,
+                "%c %d %zu",
+                (char)(CELL_COLOR_EMPTY_1 + 
+                       slot->movement.y * WIDTH + 
+                       slot->movement.x),
+                slot->score,
+                slot->context.nodes);
+
+        for (size_t i = 0; i < slot->number_of_lines; ++i) {
+            const root_line_t* line = &slot->lines[i];
+            fprintf(output, " | %d", line->score);
+
+            for (size_t j = 0; j < line->pv_length; ++j) {
+                fprintf(output, " %d", line->pv[j] + 1);
+            }
+        }
+
+        fputc('\n', output);
+    }
+}
+
+/***************************************************************
+Writes the solved lines in input order as long as there are any.
+***************************************************************/
+static void analysis_writer_routine(analysis_pipeline_t* pipeline)
+{
+    mutex_t_lock(&pipeline->mutex);
+
+    while (true) {
+        analysis_slot_t* slot = 
+            &pipeline->slots[pipeline->written % pipeline->capacity];
+
+        if (pipeline->written < pipeline->claimed && slot->solved) {
+            mutex_t_unlock(&pipeline->mutex);
+            TELEMETRY(uint64_t start = micros());
+            analysis_slot_t_write(slot, 
+                                  pipeline->written,
+                                  pipeline->output, 
+                                  pipeline->telemetry_file);
+#if SEARCH_TELEMETRY
+            if (pipeline->trace_writer != NULL) {
+                trace_writer_t_add_event(pipeline->trace_writer,
+                                         "write",
+                                         ANALYSIS_WRITER_THREAD_ID,
+                                         start,
+                                         micros());
+            }
+#endif
+            mutex_t_lock(&pipeline->mutex);
+
+            pipeline->written++;
+            condition_t_broadcast(&pipeline->slot_released);
+        } else if (pipeline->input_exhausted && 
+                   pipeline->written == pipeline->parsed) {
+            break;
+        } else {
+            condition_t_wait(&pipeline->line_solved, &pipeline->mutex);
+        }
+    }
+
+    mutex_t_unlock(&pipeline->mutex);
+}
+
+/*******************************************************************
+Analyses every position in 'input' and writes one result line per
+position to 'output'. The lines are parsed in a thread of their own,
+solved by 'number_of_solvers' threads and written by the calling
+thread, never holding more than 'capacity' positions at a time.
+'number_of_lines' best movements are ranked per position if not 0.
+The search telemetry goes to 'telemetry_file' and the trace of the
+pipeline to 'trace_writer' unless they are NULL.
+*******************************************************************/
+static bool analyze_positions(FILE* input,
+                              FILE* output,
+                              size_t number_of_solvers,
+                              size_t capacity,
+                              size_t number_of_lines,
+                              FILE* telemetry_file,
+                              trace_writer_t* trace_writer)
+{
+    analysis_pipeline_t pipeline;
+    thread_t parser;
+    analysis_solver_t* solvers = 
+        malloc(sizeof(analysis_solver_t) * number_of_solvers);
+    size_t number_of_started_solvers = 0;
+    bool parser_started;
+
+    pipeline.input = input;
+    pipeline.output = output;
+    pipeline.telemetry_file = telemetry_file;
+    pipeline.trace_writer = trace_writer;
+    pipeline.slots = malloc(sizeof(analysis_slot_t) * capacity);
+    pipeline.capacity = capacity;
+    pipeline.number_of_lines = number_of_lines;
+    pipeline.parsed = 0;
+    pipeline.claimed = 0;
+    pipeline.written = 0;
+    pipeline.input_exhausted = false;
+
+    if (solvers == NULL || pipeline.slots == NULL) {
+        free(solvers);
+        free(pipeline.slots);
+        return false;
+    }
+
+    for (size_t i = 0; i < capacity; ++i) {
+        board_t_init(&pipeline.slots[i].board);
+        pipeline.slots[i].solved = false;
+    }
+
+    mutex_t_init(&pipeline.mutex);
+    condition_t_init(&pipeline.slot_released);
+    condition_t_init(&pipeline.line_parsed);
+    condition_t_init(&pipeline.line_solved);
+
+    for (size_t i = 0; i < number_of_solvers; ++i) {
+        solvers[i].pipeline = &pipeline;
+        solvers[i].thread_id = ANALYSIS_FIRST_SOLVER_THREAD_ID + i;
+    }
+
+    while (number_of_started_solvers < number_of_solvers &&
+           thread_t_start(&solvers[number_of_started_solvers].thread,
+                          analysis_solver_routine,
+                          &solvers[number_of_started_solvers])) {
+        number_of_started_solvers++;
+    }
+
+    parser_started = number_of_started_solvers > 0 &&
+                     thread_t_start(&parser,
+                                    analysis_parser_routine,
+                                    &pipeline);
+
+    if (parser_started) {
+        analysis_writer_routine(&pipeline);
+        thread_t_join(&parser);
+    } else {
+        // Release the solvers waiting for the input.
+        mutex_t_lock(&pipeline.mutex);
+        pipeline.input_exhausted = true;
+        condition_t_broadcast(&pipeline.line_parsed);
+        mutex_t_unlock(&pipeline.mutex);
+    }
+
+    for (size_t i = 0; i < number_of_started_solvers; ++i) {
+        thread_t_join(&solvers[i].thread);
+    }
+
+    condition_t_free(&pipeline.line_solved);
+    condition_t_free(&pipeline.line_parsed);
+    condition_t_free(&pipeline.slot_released);
+    mutex_t_free(&pipeline.mutex);
+
+    for (size_t i = 0; i < capacity; ++i) {
+        board_t_free(&pipeline.slots[i].board);
+    }
+
+    free(pipeline.slots);
+    free(solvers);
+    fflush(output);
+    return parser_started;
+}
+
+#define MNK_MAX_SIDE 8
+#define MNK_MAX_CELLS 64
+#define MNK_MAX_CELL_LINES (4 * MNK_MAX_SIDE)
+#define MNK_TABLE_BITS 22
+
+/*******************************************************************
+The rules of an m,n,k-game: 'k' in a row wins on a 'width' x
+'height' board of at most 64 cells, the cell (x, y) being the bit
+y * width + x. The lines are all the k long runs of cells, in rows,
+columns and both diagonals.
+*******************************************************************/
+typedef struct mnk_rules_t
+{
+    size_t width;
+    size_t height;
+    size_t k;
+    uint64_t full; // All the cells of the board.
+    uint64_t* lines;
+    size_t number_of_lines;
+    int cell_weights[MNK_MAX_CELLS]; // The lines through each cell.
+    uint64_t zobrist_keys[2][MNK_MAX_CELLS];
+} mnk_rules_t;
+
+/*******************************************************************
+Computes the lines of the game. Returns false if the dimensions are
+not supported or out of memory. The Zobrist keys come from a fixed
+seed so that every process agrees on them.
+*******************************************************************/
+static bool mnk_rules_t_init(mnk_rules_t* rules,
+                             size_t width,
+                             size_t height,
+                             size_t k)
+{
+    static const int DIRECTIONS[4][2] = { { 1, 0 }, { 0, 1 }, 
+                                          { 1, 1 }, { 1, -1 } };
+    uint64_t seed = 0x6d6e6b;
+
+    if (width < 1 || width > MNK_MAX_SIDE || 
+        height < 1 || height > MNK_MAX_SIDE ||
+        k < 1 || k > MAX(width, height)) {
+        return false;
+    }
+
+    rules->width = width;
+    rules->height = height;
+    rules->k = k;
+    rules->full = width * height == 64 
+        ? ~0ULL 
+        : (1ULL << (width * height)) - 1;
+    rules->number_of_lines = 0;
+    rules->lines = malloc(sizeof(uint64_t) * 4 * width * height);
+
+    if (rules->lines == NULL) {
+        return false;
+    }
+
+    memset(rules->cell_weights, 0, sizeof(rules->cell_weights));
+
+    for (int y = 0; y < (int)height; ++y) {
+        for (int x = 0; x < (int)width; ++x) {
+            for (size_t d = 0; d < 4; ++d) {
+                int end_x = x + DIRECTIONS[d][0] * (int)(k - 1);
+                int end_y = y + DIRECTIONS[d][1] * (int)(k - 1);
+                uint64_t line = 0;
+
+                if (end_x < 0 || end_x >= (int)width || 
+                    end_y < 0 || end_y >= (int)height ||
+                    (k == 1 && d > 0)) {
+                    continue;
+                }
+
+                for (int i = 0; i < (int)k; ++i) {
+                    line |= 1ULL << ((y + DIRECTIONS[d][1] * i) * width +
+                                     x + DIRECTIONS[d][0] * i);
+                }
+
+                rules->lines[rules->number_of_lines++] = line;
+
+                for (uint64_t cells = line; cells != 0; cells &= cells - 1) {
+                    rules->cell_weights[bit_scan_forward64(cells)]++;
+                }
+            }
+        }
+    }
+
+    for (size_t cell = 0; cell < MNK_MAX_CELLS; ++cell) {
+        rules->zobrist_keys[PLAYER_X][cell] = split_mix_64(&seed);
+        rules->zobrist_keys[PLAYER_O][cell] = split_mix_64(&seed);
+    }
+
+    return true;
+}
+
+static void mnk_rules_t_free(mnk_rules_t* rules)
+{
+    free(rules->lines);
+}
+
+/*******************************************************************
+Returns the cells that complete a line of 'own' not blocked by
+'opponent', occupied or not.
+*******************************************************************/
+static uint64_t mnk_rules_t_completing_cells(const mnk_rules_t* rules,
+                                             uint64_t own,
+                                             uint64_t opponent)
+{
+    uint64_t cells = 0;
+
+    for (size_t i = 0; i < rules->number_of_lines; ++i) {
+        uint64_t line = rules->lines[i];
+
+        if ((line & opponent) == 0 && 
+            (size_t)popcount64(line & own) == rules->k - 1) {
+            cells |= line & ~own;
+        }
+    }
+
+    return cells;
+}
+
+static bool mnk_rules_t_has_line(const mnk_rules_t* rules, uint64_t own)
+{
+    for (size_t i = 0; i < rules->number_of_lines; ++i) {
+        if ((rules->lines[i] & own) == rules->lines[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************
+Replays the movements 'cells' on the empty board, X moving first, to
+the marks of the player to move ('own') and of the other one. Stores
+the Zobrist key of the position to 'key', if not NULL. Returns false
+if a cell is off the board or occupied.
+*******************************************************************/
+static bool mnk_rules_t_replay(const mnk_rules_t* rules,
+                               const uint8_t* cells,
+                               size_t count,
+                               uint64_t* own,
+                               uint64_t* opponent,
+                               uint64_t* key)
+{
+    uint64_t marks[2] = { 0, 0 };
+    uint64_t position_key = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t bit = 1ULL << cells[i];
+
+        if (cells[i] >= MNK_MAX_CELLS ||
+            (rules->full & bit) == 0 ||
+            ((marks[0] | marks[1]) & bit) != 0) {
+            return false;
+        }
+
+        marks[i % 2] |= bit;
+        position_key ^= rules->zobrist_keys[i % 2 == 0 ? PLAYER_X 
+                                                       : PLAYER_O][cells[i]];
+    }
+
+    *own = marks[count % 2];
+    *opponent = marks[(count + 1) % 2];
+
+    if (key != NULL) {
+        *key = position_key;
+    }
+
+    return true;
+}
+
+/*******************************************************************
+An exhaustive m,n,k-game solver: an alpha-beta search to the end of
+the game with a transposition table, kept between the positions
+solved since they share their subtrees.
+*******************************************************************/
+typedef struct mnk_solver_t
+{
+    const mnk_rules_t* rules;
+    transposition_table_t table;
+    uint32_t history[MNK_MAX_CELLS];
+    search_context_t context;
+} mnk_solver_t;
+
+static bool mnk_solver_t_init(mnk_solver_t* solver, const mnk_rules_t* rules)
+{
+    memset(solver, 0, sizeof(*solver));
+    solver->rules = rules;
+    return transposition_table_t_init(&solver->table, MNK_TABLE_BITS);
+}
+
+static void mnk_solver_t_free(mnk_solver_t* solver)
+{
+    transposition_table_t_free(&solver->table);
+}
+
+/*******************************************************************
+Solves the position of 'ply' pieces, 'own' to move, in which no line
+is complete. The fail-soft score is from the point of view of 'own':
+SEARCH_WIN_SCORE minus the number of the pieces at the end of the
+game for a win, its negation for a loss and 0 for a draw. Counting
+the pieces instead of the plies from the root keeps the scores of
+the positions comparable across the work units.
+*******************************************************************/
+static int mnk_solver_t_search(mnk_solver_t* solver,
+                               uint64_t own,
+                               uint64_t opponent,
+                               uint64_t key,
+                               int ply,
+                               int alpha,
+                               int beta)
+{
+    const mnk_rules_t* rules = solver->rules;
+    uint64_t empty = rules->full & ~(own | opponent);
+
+    solver->context.nodes++;
+
+    if (empty == 0) {
+        return 0;
+    }
+
+    if (mnk_rules_t_completing_cells(rules, own, opponent) & empty) {
+        return SEARCH_WIN_SCORE - (ply + 1);
+    }
+
+    uint64_t threats = mnk_rules_t_completing_cells(rules, opponent, own) & 
+                       empty;
+
+    if (popcount64(threats) > 1) {
+        return -(SEARCH_WIN_SCORE - (ply + 2));
+    }
+
+    // Winning takes at least two more own movements from now on.
+    if (SEARCH_WIN_SCORE - (ply + 3) <= alpha) {
+        return SEARCH_WIN_SCORE - (ply + 3);
+    }
+
+    int depth = popcount64(empty);
+    const table_entry_t* entry = 
+        transposition_table_t_probe(&solver->table, key, &solver->context);
+    int table_movement = entry != NULL ? entry->movement : -1;
+    int table_score;
+
+    if (entry != NULL &&
+        table_entry_t_cuts_off(entry, depth, ply, alpha, beta, &table_score)) {
+        return table_score;
+    }
+
+    uint8_t movements[MNK_MAX_CELLS];
+    int ratings[MNK_MAX_CELLS];
+    size_t count = 0;
+
+    for (uint64_t cells = threats != 0 ? threats : empty; 
+         cells != 0; 
+         cells &= cells - 1) {
+        size_t cell = bit_scan_forward64(cells);
+        movements[count] = (uint8_t)cell;
+        ratings[count] = (int)cell == table_movement 
+            ? POSITIVE_INFINITY
+            : (rules->cell_weights[cell] << 16) + 
+              (int)MIN(solver->history[cell], 0xffffu);
+        count++;
+    }
+
+    PlayerColor color = ply % 2 == 0 ? PLAYER_X : PLAYER_O;
+    int original_alpha = alpha;
+    int best_score = NEGATIVE_INFINITY;
+    size_t best_movement = movements[0];
+
+    for (size_t i = 0; i < count; ++i) {
+        select_movement(movements, ratings, i, count);
+
+        int score = -mnk_solver_t_search(
+            solver,
+            opponent,
+            own | 1ULL << movements[i],
+            key ^ rules->zobrist_keys[color][movements[i]],
+            ply + 1,
+            -beta,
+            -alpha);
+
+        if (score > best_score) {
+            best_score = score;
+            best_movement = movements[i];
+        }
+
+        alpha = MAX(alpha, score);
+
+        if (alpha >= beta) {
+            solver->history[movements[i]] += (uint32_t)(depth * depth);
+            break;
+        }
+    }
+
+    transposition_table_t_store(&solver->table,
+                                key,
+                                depth,
+                                ply,
+                                best_score,
+                                original_alpha,
+                                beta,
+                                best_movement);
+    return best_score;
+}
+
+/*******************************************************************
+Solves the position after the movements 'cells' within the window
+('alpha', 'beta'). Stores how the score relates to the window to
+'bound'.
+*******************************************************************/
+static int mnk_solver_t_solve(mnk_solver_t* solver,
+                              const uint8_t* cells,
+                              size_t count,
+                              int alpha,
+                              int beta,
+                              TableBound* bound)
+{
+    uint64_t own, opponent, key;
+    mnk_rules_t_replay(solver->rules, cells, count, &own, &opponent, &key);
+
+    int score = mnk_solver_t_search(solver, 
+                                    own, 
+                                    opponent, 
+                                    key, 
+                                    (int)count, 
+                                    alpha, 
+                                    beta);
+
+    *bound = score <= alpha ? BOUND_UPPER :
+             score >= beta ? BOUND_LOWER : BOUND_EXACT;
+    return score;
+}
+
+/*******************************************************************
+The distributed solver. The coordinator splits the game tree at a
+fixed depth: the positions there become work units, transpositions
+sharing one. Workers connect over TCP and solve one unit at a time
+within the window of the solve. The coordinator backs the results up
+the split tree and stops as soon as the root is settled.
+
+The protocol is line based text:
+    coordinator: GAME <version> <width> <height> <k>
+    coordinator: UNIT <id> <alpha> <beta> <count> <cell>...
+    worker:      RESULT <id> <score> <bound> <nodes>
+    coordinator: DONE
+A unit of a worker that disconnects, or holds it longer than the
+lease, goes to the next idle worker. Every result is appended to the
+checkpoint file, from which an interrupted solve resumes.
+*******************************************************************/
+#define SOLVER_PROTOCOL_VERSION 1
+#define SOLVER_NONE UINT32_MAX
+#define SOLVER_MAX_CONNECTIONS 256
+#if defined(_WIN32) && FD_SETSIZE < SOLVER_MAX_CONNECTIONS + 1
+#error "FD_SETSIZE must cover SOLVER_MAX_CONNECTIONS and the listener."
+#endif
+#define SOLVER_MAX_RESTARTS_PER_WORKER 3
+#define SOLVER_DEFAULT_SPLIT_DEPTH 2
+
+typedef enum WorkUnitState
+{
+    UNIT_PENDING,
+    UNIT_ASSIGNED,
+    UNIT_DONE,
+    UNIT_SKIPPED, // Settled by the other results before assigned.
+} WorkUnitState;
+
+typedef struct work_unit_t
+{
+    uint64_t key;
+    uint32_t node;        // The first split node of the position.
+    uint8_t state;        // WorkUnitState.
+    uint64_t assigned_at; // micros() of the latest assignment.
+    uint64_t nodes;       // Searched by the worker.
+} work_unit_t;
+
+/*******************************************************************
+A node of the split tree. The score interval ['lower', 'upper'] is
+from the point of view of the player to move and narrows down as the
+results of the units below arrive.
+*******************************************************************/
+typedef struct split_node_t
+{
+    uint32_t parent;
+    uint32_t first_child;  // The children are consecutive.
+    uint32_t unit;         // SOLVER_NONE unless a unit.
+    uint32_t next_of_unit; // The next node of the same unit.
+    int32_t lower;
+    int32_t upper;
+    uint8_t number_of_children;
+    uint8_t cell;          // The movement leading here.
+    uint8_t ply;
+} split_node_t;
+
+typedef struct coordinator_t
+{
+    const mnk_rules_t* rules;
+    size_t split_depth;
+    int alpha; // The window of the root.
+    int beta;
+    split_node_t* nodes;
+    size_t number_of_nodes;
+    size_t nodes_capacity;
+    work_unit_t* units;
+    size_t number_of_units;
+    uint32_t* unit_table; // Unit indices by key, open addressing.
+    size_t unit_table_mask;
+    uint32_t* requeued;   // Units taken back from workers.
+    size_t number_of_requeued;
+    size_t next_unit;     // The next unit never assigned.
+    size_t units_done;
+    size_t units_restored;
+    uint64_t nodes_searched;
+    FILE* checkpoint;
+} coordinator_t;
+
+static void coordinator_t_free(coordinator_t* coordinator)
+{
+    free(coordinator->nodes);
+    free(coordinator->units);
+    free(coordinator->unit_table);
+    free(coordinator->requeued);
+
+    if (coordinator->checkpoint != NULL) {
+        fclose(coordinator->checkpoint);
+    }
+}
+
+static uint32_t coordinator_t_add_node(coordinator_t* coordinator,
+                                       uint32_t parent,
+                                       size_t cell,
+                                       size_t ply)
+{
+    if (coordinator->number_of_nodes == coordinator->nodes_capacity) {
+        size_t capacity = MAX(2 * coordinator->nodes_capacity, 1024);
+        split_node_t* nodes = capacity < SOLVER_NONE 
+            ? realloc(coordinator->nodes, capacity * sizeof(split_node_t))
+            : NULL;
+
+        if (nodes == NULL) {
+            return SOLVER_NONE;
+        }
+
+        coordinator->nodes = nodes;
+        coordinator->nodes_capacity = capacity;
+    }
+
+    split_node_t* node = &coordinator->nodes[coordinator->number_of_nodes];
+    node->parent = parent;
+    node->first_child = SOLVER_NONE;
+    node->unit = SOLVER_NONE;
+    node->next_of_unit = SOLVER_NONE;
+    node->lower = -SEARCH_WIN_SCORE;
+    node->upper = SEARCH_WIN_SCORE;
+    node->number_of_children = 0;
+    node->cell = (uint8_t)cell;
+    node->ply = (uint8_t)ply;
+    return (uint32_t)coordinator->number_of_nodes++;
+}
+
+/*******************************************************************
+Stores the movements leading to the node to 'cells', returning their
+number.
+*******************************************************************/
+static size_t coordinator_t_get_path(const coordinator_t* coordinator,
+                                     uint32_t node_index,
+                                     uint8_t cells[MNK_MAX_CELLS])
+{
+    size_t count = coordinator->nodes[node_index].ply;
+
+    for (size_t i = count; i > 0; --i) {
+        cells[i - 1] = coordinator->nodes[node_index].cell;
+        node_index = coordinator->nodes[node_index].parent;
+    }
+
+    return count;
+}
+
+/*******************************************************************
+Returns the current window of the node. As in a sequential alpha-beta
+search, the window of a child is the negated window of its parent,
+narrowed down by the best score the parent is already known to get.
+The windows only narrow down as the results arrive.
+*******************************************************************/
+static void coordinator_t_get_window(const coordinator_t* coordinator,
+                                     uint32_t node_index,
+                                     int* alpha,
+                                     int* beta)
+{
+    uint32_t path[MNK_MAX_CELLS + 1];
+    size_t length = 0;
+    int window_alpha = coordinator->alpha;
+    int window_beta = coordinator->beta;
+
+    for (uint32_t node = node_index; 
+         node != SOLVER_NONE; 
+         node = coordinator->nodes[node].parent) {
+        path[length++] = node;
+    }
+
+    for (size_t i = length - 1; i > 0; --i) {
+        int parent_alpha = MAX(window_alpha, coordinator->nodes[path[i]].lower);
+        window_alpha = -window_beta;
+        window_beta = -parent_alpha;
+    }
+
+    *alpha = window_alpha;
+    *beta = window_beta;
+}
+
+/*******************************************************************
+Returns true if the score of the node is exact or known to fall
+outside of its window, in which case nothing below it matters.
+*******************************************************************/
+static bool coordinator_t_is_settled(const coordinator_t* coordinator,
+                                     uint32_t node_index)
+{
+    const split_node_t* node = &coordinator->nodes[node_index];
+    int alpha, beta;
+    coordinator_t_get_window(coordinator, node_index, &alpha, &beta);
+
+    return node->lower == node->upper || 
+           node->lower >= beta || 
+           node->upper <= alpha;
+}
+
+/*******************************************************************
+Recomputes the interval of the node from those of its children.
+Returns false if it did not change.
+*******************************************************************/
+static bool coordinator_t_back_up(coordinator_t* coordinator,
+                                  uint32_t node_index)
+{
+    split_node_t* node = &coordinator->nodes[node_index];
+    int lower = NEGATIVE_INFINITY;
+    int upper = NEGATIVE_INFINITY;
+
+    for (size_t i = 0; i < node->number_of_children; ++i) {
+        const split_node_t* child = 
+            &coordinator->nodes[node->first_child + i];
+        lower = MAX(lower, -child->upper);
+        upper = MAX(upper, -child->lower);
+    }
+
+    if (lower == node->lower && upper == node->upper) {
+        return false;
+    }
+
+    node->lower = lower;
+    node->upper = upper;
+    return true;
+}
+
+static uint32_t* coordinator_t_find_unit_slot(coordinator_t* coordinator,
+                                              uint64_t key)
+{
+    size_t slot = (size_t)key & coordinator->unit_table_mask;
+
+    while (coordinator->unit_table[slot] != SOLVER_NONE &&
+           coordinator->units[coordinator->unit_table[slot]].key != key) {
+        slot = (slot + 1) & coordinator->unit_table_mask;
+    }
+
+    return &coordinator->unit_table[slot];
+}
+
+/*******************************************************************
+Expands the tree breadth first down to the split depth. The game
+ends at some nodes on the way, which get their exact scores; the
+other nodes at the split depth become the work units. Returns false
+if out of memory.
+*******************************************************************/
+static bool coordinator_t_split(coordinator_t* coordinator)
+{
+    const mnk_rules_t* rules = coordinator->rules;
+    uint8_t cells[MNK_MAX_CELLS];
+    size_t number_of_leaves = 0;
+
+    if (coordinator_t_add_node(coordinator, SOLVER_NONE, 0, 0) 
+            == SOLVER_NONE) {
+        return false;
+    }
+
+    for (size_t i = 0; i < coordinator->number_of_nodes; ++i) {
+        uint64_t own, opponent;
+        size_t ply = coordinator_t_get_path(coordinator, (uint32_t)i, cells);
+
+        if (coordinator->nodes[i].lower == coordinator->nodes[i].upper) {
+            continue;
+        }
+
+        if (ply == coordinator->split_depth) {
+            number_of_leaves++;
+            continue;
+        }
+
+        mnk_rules_t_replay(rules, cells, ply, &own, &opponent, NULL);
+        coordinator->nodes[i].first_child = 
+            (uint32_t)coordinator->number_of_nodes;
+
+        for (uint64_t empty = rules->full & ~(own | opponent);
+             empty != 0;
+             empty &= empty - 1) {
+            size_t cell = bit_scan_forward64(empty);
+            uint32_t child = 
+                coordinator_t_add_node(coordinator, (uint32_t)i, cell, ply + 1);
+
+            if (child == SOLVER_NONE) {
+                return false;
+            }
+
+            coordinator->nodes[i].number_of_children++;
+
+            // The player who moved to the child has just won, or
+            // the board is full.
+            if (mnk_rules_t_has_line(rules, own | 1ULL << cell)) {
+                coordinator->nodes[child].lower = 
+                    -(SEARCH_WIN_SCORE - (int)(ply + 1));
+                coordinator->nodes[child].upper = 
+                    coordinator->nodes[child].lower;
+            } else if (((own | opponent | 1ULL << cell) & rules->full) == 
+                       rules->full) {
+                coordinator->nodes[child].lower = 0;
+                coordinator->nodes[child].upper = 0;
+            }
+        }
+    }
+
+    size_t table_size = 1;
+
+    while (table_size < 2 * number_of_leaves) {
+        table_size *= 2;
+    }
+
+    coordinator->units = malloc(MAX(number_of_leaves, 1) * 
+                                sizeof(work_unit_t));
+    coordinator->requeued = malloc(MAX(number_of_leaves, 1) * 
+                                   sizeof(uint32_t));
+    coordinator->unit_table = malloc(table_size * sizeof(uint32_t));
+    coordinator->unit_table_mask = table_size - 1;
+
+    if (coordinator->units == NULL || 
+        coordinator->requeued == NULL ||
+        coordinator->unit_table == NULL) {
+        return false;
+    }
+
+    memset(coordinator->unit_table, 0xff, table_size * sizeof(uint32_t));
+
+    for (size_t i = 0; i < coordinator->number_of_nodes; ++i) {
+        split_node_t* node = &coordinator->nodes[i];
+        uint64_t own, opponent, key;
+
+        if (node->ply != coordinator->split_depth || 
+            node->lower == node->upper) {
+            continue;
+        }
+
+        size_t ply = coordinator_t_get_path(coordinator, (uint32_t)i, cells);
+        mnk_rules_t_replay(rules, cells, ply, &own, &opponent, &key);
+
+        uint32_t* slot = coordinator_t_find_unit_slot(coordinator, key);
+
+        if (*slot == SOLVER_NONE) {
+            work_unit_t* unit = &coordinator->units[coordinator->number_of_units];
+            unit->key = key;
+            unit->node = (uint32_t)i;
+            unit->state = UNIT_PENDING;
+            unit->assigned_at = 0;
+            unit->nodes = 0;
+            *slot = (uint32_t)coordinator->number_of_units++;
+        } else {
+            // Chain the node after the first node of the unit.
+            split_node_t* first = 
+                &coordinator->nodes[coordinator->units[*slot].node];
+            node->next_of_unit = first->next_of_unit;
+            first->next_of_unit = (uint32_t)i;
+        }
+
+        node->unit = *slot;
+    }
+
+    // Children come after their parents.
+    for (size_t i = coordinator->number_of_nodes; i > 0; --i) {
+        if (coordinator->nodes[i - 1].number_of_children > 0) {
+            coordinator_t_back_up(coordinator, (uint32_t)(i - 1));
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************
+Returns true if the result of the unit may still change the score of
+the root: some node of the unit has no settled ancestor. Stores the
+window that serves all such nodes to 'alpha' and 'beta'.
+*******************************************************************/
+static bool coordinator_t_get_unit_window(const coordinator_t* coordinator,
+                                          uint32_t unit_index,
+                                          int* alpha,
+                                          int* beta)
+{
+    bool needed = false;
+
+    for (uint32_t node = coordinator->units[unit_index].node;
+         node != SOLVER_NONE;
+         node = coordinator->nodes[node].next_of_unit) {
+        uint32_t ancestor = coordinator->nodes[node].parent;
+        int node_alpha, node_beta;
+
+        while (ancestor != SOLVER_NONE && 
+               !coordinator_t_is_settled(coordinator, ancestor)) {
+            ancestor = coordinator->nodes[ancestor].parent;
+        }
+
+        if (ancestor != SOLVER_NONE) {
+            continue;
+        }
+
+        coordinator_t_get_window(coordinator, node, &node_alpha, &node_beta);
+        *alpha = needed ? MIN(*alpha, node_alpha) : node_alpha;
+        *beta = needed ? MAX(*beta, node_beta) : node_beta;
+        needed = true;
+    }
+
+    return needed;
+}
+
+/*******************************************************************
+Records the score interval of a solved unit and backs it up the
+split tree.
+*******************************************************************/
+static void coordinator_t_complete_unit(coordinator_t* coordinator,
+                                        uint32_t unit_index,
+                                        int lower,
+                                        int upper,
+                                        uint64_t nodes)
+{
+    work_unit_t* unit = &coordinator->units[unit_index];
+
+    unit->state = UNIT_DONE;
+    unit->nodes = nodes;
+    coordinator->nodes_searched += nodes;
+
+    for (uint32_t node = unit->node;
+         node != SOLVER_NONE;
+         node = coordinator->nodes[node].next_of_unit) {
+        coordinator->nodes[node].lower = lower;
+        coordinator->nodes[node].upper = upper;
+
+        for (uint32_t ancestor = coordinator->nodes[node].parent;
+             ancestor != SOLVER_NONE && 
+             coordinator_t_back_up(coordinator, ancestor);
+             ancestor = coordinator->nodes[ancestor].parent) {
+        }
+    }
+}
+
+/*******************************************************************
+Returns the next unit to assign, or SOLVER_NONE if there is none
+now. The units taken back from workers go first. The units no
+longer needed are skipped for good.
+*******************************************************************/
+static uint32_t coordinator_t_next_unit(coordinator_t* coordinator)
+{
+    int alpha, beta;
+
+    while (coordinator->number_of_requeued > 0) {
+        uint32_t unit = 
+            coordinator->requeued[--coordinator->number_of_requeued];
+
+        if (coordinator->units[unit].state != UNIT_PENDING) {
+            continue;
+        }
+
+        if (coordinator_t_get_unit_window(coordinator, unit, &alpha, &beta)) {
+            return unit;
+        }
+
+        coordinator->units[unit].state = UNIT_SKIPPED;
+    }
+
+    while (coordinator->next_unit < coordinator->number_of_units) {
+        uint32_t unit = (uint32_t)coordinator->next_unit++;
+
+        if (coordinator->units[unit].state != UNIT_PENDING) {
+            continue;
+        }
+
+        if (coordinator_t_get_unit_window(coordinator, unit, &alpha, &beta)) {
+            return unit;
+        }
+
+        coordinator->units[unit].state = UNIT_SKIPPED;
+    }
+
+    return SOLVER_NONE;
+}
+
+/*******************************************************
+Puts an assigned unit back to be assigned to another worker.
+*******************************************************/
+static void coordinator_t_requeue(coordinator_t* coordinator,
+                                  uint32_t unit_index)
+{
+    if (coordinator->units[unit_index].state == UNIT_ASSIGNED) {
+        coordinator->units[unit_index].state = UNIT_PENDING;
+        coordinator->requeued[coordinator->number_of_requeued++] = unit_index;
+    }
+}
+
+/*******************************************************************
+Writes the checkpoint header identifying the solve, e.g.
+"TTTC 1 4 4 4 2 -1 1" for the 4x4 board, 4 in a row, split depth 2
+and the window (-1, 1).
+*******************************************************************/
+static void coordinator_t_format_checkpoint_header(
+    const coordinator_t* coordinator,
+    char* header,
+    size_t capacity)
+{
+    snprintf(header,
+             capacity,
+             "TTTC 1 %zu %zu %zu %zu %d %d\n",
+             coordinator->rules->width,
+             coordinator->rules->height,
+             coordinator->rules->k,
+             coordinator->split_depth,
+             coordinator->alpha,
+             coordinator->beta);
+}
+
+/*******************************************************************
+Opens the checkpoint at 'path', first restoring the units it has
+results for. A missing file starts a new checkpoint. Returns false
+if the file belongs to another solve or cannot be written. Each
+result is a line "<key> <lower> <upper> <nodes>"; a line cut short
+by a crash is ignored.
+*******************************************************************/
+static bool coordinator_t_open_checkpoint(coordinator_t* coordinator,
+                                          const wchar_t* path)
+{
+    char expected_header[128];
+    char line[128];
+    FILE* file = open_file(path, "r");
+    bool needs_header = true;
+    bool needs_newline = false;
+
+    coordinator_t_format_checkpoint_header(coordinator, 
+                                           expected_header, 
+                                           sizeof(expected_header));
+
+    if (file != NULL) {
+        if (fgets(line, sizeof(line), file) != NULL) {
+            if (strcmp(line, expected_header) != 0) {
+                fprintf(stderr, 
+                        "The checkpoint %ls belongs to another solve.\n", 
+                        path);
+                fclose(file);
+                return false;
+            }
+
+            needs_header = false;
+        }
+
+        while (fgets(line, sizeof(line), file) != NULL) {
+            unsigned long long key, nodes;
+            int lower, upper;
+            size_t length = strlen(line);
+
+            needs_newline = length > 0 && line[length - 1] != '\n';
+
+            if (sscanf(line, 
+                       "%llx %d %d %llu", 
+                       &key, 
+                       &lower, 
+                       &upper, 
+                       &nodes) != 4 || 
+                needs_newline) {
+                continue;
+            }
+
+            uint32_t unit = 
+                *coordinator_t_find_unit_slot(coordinator, (uint64_t)key);
+
+            if (unit != SOLVER_NONE && 
+                coordinator->units[unit].state == UNIT_PENDING) {
+                coordinator_t_complete_unit(coordinator, 
+                                            unit, 
+                                            lower, 
+                                            upper, 
+                                            (uint64_t)nodes);
+                coordinator->units_restored++;
+            }
+        }
+
+        fclose(file);
+    }
+
+    coordinator->checkpoint = open_file(path, "a");
+
+    if (coordinator->checkpoint == NULL) {
+        fprintf(stderr, "Could not open the checkpoint %ls.\n", path);
+        return false;
+    }
+
+    if (needs_header) {
+        fputs(expected_header, coordinator->checkpoint);
+    } else if (needs_newline) {
+        fputc('\n', coordinator->checkpoint);
+    }
+
+    fflush(coordinator->checkpoint);
+    return true;
+}
+
+static void coordinator_t_write_checkpoint(coordinator_t* coordinator,
+                                           uint32_t unit_index,
+                                           int lower,
+                                           int upper)
+{
+    if (coordinator->checkpoint != NULL) {
+        fprintf(coordinator->checkpoint,
+                "%016llx %d %d %llu\n",
+                (unsigned long long)coordinator->units[unit_index].key,
+                lower,
+                upper,
+                (unsigned long long)coordinator->units[unit_index].nodes);
+        fflush(coordinator->checkpoint);
+    }
+}
+
+/****************************************************
+A worker connected to the coordinator.
+****************************************************/
+typedef struct worker_connection_t
+{
+    line_reader_t reader;
+    uint32_t unit; // SOLVER_NONE while idle.
+} worker_connection_t;
+
+static bool coordinator_t_send_unit(coordinator_t* coordinator,
+                                    worker_connection_t* connection,
+                                    uint32_t unit_index)
+{
+    work_unit_t* unit = &coordinator->units[unit_index];
+    uint8_t cells[MNK_MAX_CELLS];
+    char line[SOCKET_LINE_CAPACITY];
+    size_t count = coordinator_t_get_path(coordinator, unit->node, cells);
+    int alpha, beta;
+
+    coordinator_t_get_unit_window(coordinator, unit_index, &alpha, &beta);
+
+    int length = snprintf(line, 
+                          sizeof(line), 
+                          "UNIT %u %d %d %zu", 
+                          unit_index, 
+                          alpha, 
+                          beta, 
+                          count);
+
+    for (size_t i = 0; i < count; ++i) {
+        length += snprintf(line + length, 
+                           sizeof(line) - (size_t)length, 
+                           " %u", 
+                           (unsigned)cells[i]);
+    }
+
+    line[length++] = '\n';
+    unit->state = UNIT_ASSIGNED;
+    unit->assigned_at = micros();
+    connection->unit = unit_index;
+    return socket_t_send_all(connection->reader.handle, line, (size_t)length);
+}
+
+/*******************************************************************
+Handles a line from a worker. Returns false if it breaks the
+protocol.
+*******************************************************************/
+static bool coordinator_t_handle_line(coordinator_t* coordinator,
+                                      worker_connection_t* connection,
+                                      const char* line)
+{
+    unsigned unit_index;
+    int score, bound;
+    unsigned long long nodes;
+
+    if (sscanf(line, 
+               "RESULT %u %d %d %llu", 
+               &unit_index, 
+               &score, 
+               &bound, 
+               &nodes) != 4 ||
+        unit_index != connection->unit ||
+        bound < BOUND_EXACT || bound > BOUND_UPPER) {
+        return false;
+    }
+
+    connection->unit = SOLVER_NONE;
+
+    // A unit whose lease ran out may come back twice.
+    if (coordinator->units[unit_index].state == UNIT_DONE) {
+        return true;
+    }
+
+    int lower = bound == BOUND_UPPER ? -SEARCH_WIN_SCORE : score;
+    int upper = bound == BOUND_LOWER ? SEARCH_WIN_SCORE : score;
+
+    coordinator_t_complete_unit(coordinator, 
+                                unit_index, 
+                                lower, 
+                                upper, 
+                                (uint64_t)nodes);
+    coordinator_t_write_checkpoint(coordinator, unit_index, lower, upper);
+    coordinator->units_done++;
+    return true;
+}
+
+static void coordinator_t_drop(coordinator_t* coordinator,
+                               worker_connection_t* connection)
+{
+    if (connection->unit != SOLVER_NONE) {
+        coordinator_t_requeue(coordinator, connection->unit);
+    }
+
+    socket_t_close(connection->reader.handle);
+    connection->reader.handle = INVALID_SOCKET;
+    connection->unit = SOLVER_NONE;
+}
+
+/*******************************************************************
+Where the workers of a solve come from: the local ones are started
+as "<program> --work <address>" and restarted if they die, a few
+times at most.
+*******************************************************************/
+typedef struct worker_pool_t
+{
+    char* program;
+    char* address;
+    process_t* processes;
+    size_t number_of_processes;
+    size_t restarts_left;
+} worker_pool_t;
+
+static bool worker_pool_t_start(worker_pool_t* pool, process_t* process)
+{
+    char work_option[] = "--work";
+    char* arguments[] = { pool->program, work_option, pool->address, NULL };
+    return process_t_start(process, arguments);
+}
+
+/*******************************************************
+Restarts the local workers that have exited.
+*******************************************************/
+static void worker_pool_t_restart_exited(worker_pool_t* pool)
+{
+    for (size_t i = 0; i < pool->number_of_processes; ++i) {
+        process_t* process = &pool->processes[i];
+
+        if (!process_t_has_exited(process) || pool->restarts_left == 0) {
+            continue;
+        }
+
+        process_t_join(process);
+        pool->restarts_left--;
+        fprintf(stderr, "A local worker exited; restarting it.\n");
+
+        if (!worker_pool_t_start(pool, process)) {
+            process->exited = true;
+        }
+    }
+}
+
+/*******************************************************************
+Waits for the local workers to exit, telling those that connect only
+now that the solve is over.
+*******************************************************************/
+static void worker_pool_t_dismiss(worker_pool_t* pool, socket_t listener)
+{
+    while (true) {
+        bool running = false;
+
+        for (size_t i = 0; i < pool->number_of_processes; ++i) {
+            running |= !process_t_has_exited(&pool->processes[i]);
+        }
+
+        if (!running) {
+            break;
+        }
+
+        fd_set readable;
+        struct timeval timeout = { 0, 100 * 1000 };
+
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+
+        if (select((int)listener + 1, &readable, NULL, NULL, &timeout) > 0) {
+            socket_t handle = accept(listener, NULL, NULL);
+
+            if (handle != INVALID_SOCKET) {
+                socket_t_send_all(handle, "DONE\n", 5);
+                socket_t_close(handle);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pool->number_of_processes; ++i) {
+        process_t_join(&pool->processes[i]);
+    }
+}
+
+/*******************************************************************
+Runs the solve until the root is settled: accepts the workers,
+assigns them the units and collects the results. Returns false if
+the work ran out before the root was settled, which would be a bug.
+*******************************************************************/
+static bool coordinator_t_run(coordinator_t* coordinator,
+                              socket_t listener,
+                              worker_pool_t* pool,
+                              uint64_t lease_micros)
+{
+    worker_connection_t* connections = 
+        malloc(SOLVER_MAX_CONNECTIONS * sizeof(worker_connection_t));
+    char line[SOCKET_LINE_CAPACITY];
+    char game_line[64];
+    uint64_t last_report = micros();
+    size_t reported_units = SIZE_MAX;
+    bool settled = false;
+
+    if (connections == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < SOLVER_MAX_CONNECTIONS; ++i) {
+        connections[i].reader.handle = INVALID_SOCKET;
+        connections[i].unit = SOLVER_NONE;
+    }
+
+    snprintf(game_line, 
+             sizeof(game_line), 
+             "GAME %d %zu %zu %zu\n",
+             SOLVER_PROTOCOL_VERSION,
+             coordinator->rules->width,
+             coordinator->rules->height,
+             coordinator->rules->k);
+
+    while (!(settled = coordinator_t_is_settled(coordinator, 0))) {
+        size_t busy = 0;
+
+        for (size_t i = 0; i < SOLVER_MAX_CONNECTIONS; ++i) {
+            worker_connection_t* connection = &connections[i];
+
+            if (connection->reader.handle == INVALID_SOCKET) {
+                continue;
+            }
+
+            if (connection->unit == SOLVER_NONE) {
+                uint32_t unit = coordinator_t_next_unit(coordinator);
+
+                if (unit != SOLVER_NONE &&
+                    !coordinator_t_send_unit(coordinator, connection, unit)) {
+                    coordinator_t_drop(coordinator, connection);
+                    continue;
+                }
+            }
+
+            busy += connection->unit != SOLVER_NONE;
+        }
+
+        if (busy == 0 && 
+            coordinator->number_of_requeued == 0 &&
+            coordinator->next_unit == coordinator->number_of_units) {
+            break;
+        }
+
+        fd_set readable;
+        socket_t highest = listener;
+        struct timeval timeout = { 0, 200 * 1000 };
+
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+
+        for (size_t i = 0; i < SOLVER_MAX_CONNECTIONS; ++i) {
+            if (connections[i].reader.handle != INVALID_SOCKET) {
+                FD_SET(connections[i].reader.handle, &readable);
+                highest = MAX(highest, connections[i].reader.handle);
+            }
+        }
+
+        if (select((int)highest + 1, &readable, NULL, NULL, &timeout) < 0) {
+            continue;
+        }
+
+        if (FD_ISSET(listener, &readable)) {
+            socket_t handle = accept(listener, NULL, NULL);
+            worker_connection_t* connection = NULL;
+#ifndef _WIN32
+            // select() cannot poll a descriptor this high, so the
+            // result of any unit sent to it would never be read.
+            if (handle != INVALID_SOCKET && handle >= FD_SETSIZE) {
+                socket_t_close(handle);
+                handle = INVALID_SOCKET;
+            }
+#endif
+
+            for (size_t i = 0; 
+                 i < SOLVER_MAX_CONNECTIONS && handle != INVALID_SOCKET; 
+                 ++i) {
+                if (connections[i].reader.handle == INVALID_SOCKET) {
+                    connection = &connections[i];
+                    break;
+                }
+            }
+
+            if (connection != NULL) {
+                socket_t_set_no_delay(handle);
+                line_reader_t_init(&connection->reader, handle);
+
+                if (!socket_t_send_all(handle, game_line, strlen(game_line))) {
+                    coordinator_t_drop(coordinator, connection);
+                }
+            } else if (handle != INVALID_SOCKET) {
+                socket_t_close(handle);
+            }
+        }
+
+        for (size_t i = 0; i < SOLVER_MAX_CONNECTIONS; ++i) {
+            worker_connection_t* connection = &connections[i];
+
+            if (connection->reader.handle == INVALID_SOCKET ||
+                !FD_ISSET(connection->reader.handle, &readable)) {
+                continue;
+            }
+
+            bool alive = line_reader_t_receive(&connection->reader);
+
+            while (alive && 
+                   line_reader_t_next_line(&connection->reader, line)) {
+                alive = coordinator_t_handle_line(coordinator, 
+                                                  connection, 
+                                                  line);
+            }
+
+            if (!alive) {
+                coordinator_t_drop(coordinator, connection);
+            }
+        }
+
+        uint64_t now = micros();
+
+        for (size_t i = 0; i < SOLVER_MAX_CONNECTIONS && lease_micros > 0; ++i) {
+            uint32_t unit = connections[i].unit;
+
+            if (unit != SOLVER_NONE &&
+                coordinator->units[unit].state == UNIT_ASSIGNED &&
+                now - coordinator->units[unit].assigned_at > lease_micros) {
+                coordinator_t_requeue(coordinator, unit);
+            }
+        }
+
+        worker_pool_t_restart_exited(pool);
+
+        if (now - last_report >= 1000 * 1000 && 
+            reported_units != coordinator->units_done) {
+            printf("Solved %zu of %zu units.\n", 
+                   coordinator->units_done + coordinator->units_restored,
+                   coordinator->number_of_units);
+            fflush(stdout);
+            reported_units = coordinator->units_done;
+            last_report = now;
+        }
+    }
+
+    for (size_t i = 0; i < SOLVER_MAX_CONNECTIONS; ++i) {
+        if (connections[i].reader.handle != INVALID_SOCKET) {
+            socket_t_send_all(connections[i].reader.handle, "DONE\n", 5);
+            socket_t_close(connections[i].reader.handle);
+        }
+    }
+
+    free(connections);
+    return settled;
+}
+
+/*******************************************************************
+Runs a worker: connects to the coordinator at 'host' and 'service'
+and solves the units it sends until it is done. Returns false if
+the connection fails or breaks the protocol.
+*******************************************************************/
+static bool run_worker(const char* host, const char* service)
+{
+    char line[SOCKET_LINE_CAPACITY];
+    line_reader_t reader;
+    mnk_rules_t rules;
+    mnk_solver_t solver;
+    size_t width, height, k;
+    int version;
+    bool success = false;
+
+    socket_t connection = socket_t_connect(host, service);
+
+    if (connection == INVALID_SOCKET) {
+        fprintf(stderr, "Could not connect to %s:%s.\n", host, service);
+        return false;
+    }
+
+    line_reader_t_init(&reader, connection);
+
+    // A worker starting late finds the solve over.
+    if (!line_reader_t_read_line(&reader, line) || 
+        strcmp(line, "DONE") == 0) {
+        socket_t_close(connection);
+        return true;
+    }
+
+    if (sscanf(line, "GAME %d %zu %zu %zu", &version, &width, &height, &k) 
+            != 4 ||
+        version != SOLVER_PROTOCOL_VERSION ||
+        !mnk_rules_t_init(&rules, width, height, k)) {
+        fputs("The coordinator speaks another protocol.\n", stderr);
+        socket_t_close(connection);
+        return false;
+    }
+
+    if (!mnk_solver_t_init(&solver, &rules)) {
+        fputs("Could not allocate the transposition table.\n", stderr);
+        mnk_rules_t_free(&rules);
+        socket_t_close(connection);
+        return false;
+    }
+
+    // The coordinator closing the connection ends the work, too.
+    while (true) {
+        uint8_t cells[MNK_MAX_CELLS];
+        unsigned unit, count;
+        int alpha, beta, offset;
+        uint64_t own, opponent;
+        TableBound bound;
+
+        if (!line_reader_t_read_line(&reader, line) || 
+            strcmp(line, "DONE") == 0) {
+            success = true;
+            break;
+        }
+
+        if (sscanf(line, 
+                   "UNIT %u %d %d %u%n", 
+                   &unit, 
+                   &alpha, 
+                   &beta, 
+                   &count, 
+                   &offset) != 4 ||
+            count > MNK_MAX_CELLS) {
+            break;
+        }
+
+        const char* cursor = line + offset;
+        unsigned i = 0;
+
+        for (unsigned cell; i < count; ++i, cursor += offset) {
+            if (sscanf(cursor, " %u%n", &cell, &offset) != 1 || 
+                cell >= MNK_MAX_CELLS) {
+                break;
+            }
+
+            cells[i] = (uint8_t)cell;
+        }
+
+        if (i != count || 
+            !mnk_rules_t_replay(&rules, cells, count, &own, &opponent, NULL)) {
+            break;
+        }
+
+        solver.context.nodes = 0;
+
+        int score = mnk_solver_t_solve(&solver, 
+                                       cells, 
+                                       count, 
+                                       alpha, 
+                                       beta, 
+                                       &bound);
+        int length = snprintf(line, 
+                              sizeof(line),
+                              "RESULT %u %d %d %llu\n", 
+                              unit, 
+                              score, 
+                              (int)bound, 
+                              (unsigned long long)solver.context.nodes);
+
+        if (!socket_t_send_all(connection, line, (size_t)length)) {
+            break;
+        }
+    }
+
+    if (!success) {
+        fputs("The coordinator sent an invalid unit or went away.\n", 
+              stderr);
+    }
+
+    mnk_solver_t_free(&solver);
+    mnk_rules_t_free(&rules);
+    socket_t_close(connection);
+    return success;
+}
+
+/*******************************************************************
+Prints the result of the solve from the interval of the root: with
+the null window around the draw, only who wins; with the full
+window, also in how many movements.
+*******************************************************************/
+static void print_solve_result(int lower, int upper)
+{
+    if (lower >= 1) {
+        if (lower == upper && lower > SEARCH_WIN_THRESHOLD) {
+            printf("Result: X, the first player, wins in %d moves.\n",
+                   SEARCH_WIN_SCORE - lower);
+        } else {
+            puts("Result: X, the first player, wins.");
+        }
+    } else if (upper <= -1) {
+        if (lower == upper && upper < -SEARCH_WIN_THRESHOLD) {
+            printf("Result: O, the second player, wins in %d moves.\n",
+                   SEARCH_WIN_SCORE + upper);
+        } else {
+            puts("Result: O, the second player, wins.");
+        }
+    } else if (lower == 0 && upper == 0) {
+        puts("Result: draw.");
+    } else {
+        printf("Result: unsettled, between %d and %d.\n", lower, upper);
+    }
+}
+
+#define TOURNAMENT_MAX_CELLS 81
+#define TOURNAMENT_MAX_OPENING_ATTEMPTS 100
+#define TOURNAMENT_DEFAULT_PAIRS 5000
+#define TOURNAMENT_DEFAULT_OPENING_PLIES 2
+#define TOURNAMENT_DEFAULT_ELO1 10.0
+#define TOURNAMENT_ERROR_RATE 0.05
+#define TOURNAMENT_MIN_VARIANCE 1e-3
+#define TOURNAMENT_MIN_PAIRS 10
+#define TOURNAMENT_STATUS_MICROS 1000000
+
+typedef enum SprtDecision
+{
+    SPRT_CONTINUE,
+    SPRT_ACCEPT_H0,
+    SPRT_ACCEPT_H1,
+} SprtDecision;
+
+/*******************************************************************
+What one engine of a tournament has spent on its movements.
+*******************************************************************/
+typedef struct engine_statistics_t
+{
+    uint64_t nodes;
+    uint64_t search_micros;
+    uint64_t max_move_micros;
+    size_t moves;
+} engine_statistics_t;
+
+/*******************************************************************
+A match between the engines A and B, played as pairs of games from
+the same random opening with the colors swapped. The pair scores of
+A drive a sequential probability ratio test of the hypotheses that A
+is elo0 (H0) or elo1 (H1) Elo points stronger than B. The members
+below the mutex are shared by the threads playing the pairs.
+*******************************************************************/
+typedef struct tournament_t
+{
+    const game_variant_t* variant;
+    engine_settings_t settings[2];        // A and B.
+    size_t opening_plies;
+    size_t max_pairs;
+    uint64_t seed;
+    double elo0;
+    double elo1;
+    double lower_bound;                   // Accepts H0 below.
+    double upper_bound;                   // Accepts H1 above.
+    game_record_writer_t* record_writer;  // NULL unless recording.
+    uint64_t start_micros;
+    mutex_t mutex;
+    size_t next_pair;
+    size_t pair_scores[5];                // Pairs by A's half points.
+    size_t wins, draws, losses;           // Games of A.
+    engine_statistics_t statistics[2];
+    double llr;
+    SprtDecision decision;
+    bool failed;                          // A pair could not be played.
+    uint64_t last_status_micros;
+} tournament_t;
+
+/*******************************************************
+The movements of a tournament game, kept for recording.
+*******************************************************/
+typedef struct tournament_game_t
+{
+    size_t cells[TOURNAMENT_MAX_CELLS];
+    int scores[TOURNAMENT_MAX_CELLS];
+    size_t times[TOURNAMENT_MAX_CELLS];
+    bool has_score[TOURNAMENT_MAX_CELLS];
+    size_t number_of_moves;
+    WinningStatus result;
+} tournament_game_t;
+
+/*****************************************************
+Converts an expected score to a difference in Elo.
+*****************************************************/
+static double score_to_elo(double score)
+{
+    score = MIN(MAX(score, 0.001), 0.999);
+    return 400.0 * log10(score / (1.0 - score));
+}
+
+/*****************************************************
+Converts a difference in Elo to an expected score.
+*****************************************************/
+static double elo_to_score(double elo)
+{
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+/*******************************************************************
+Computes the mean and the variance of the pair scores of A, scaled
+to [0, 1]. Returns the number of pairs.
+*******************************************************************/
+static size_t tournament_t_get_score(const tournament_t* tournament,
+                                     double* mean,
+                                     double* variance)
+{
+    size_t pairs = 0;
+    double sum = 0.0;
+    double sum_of_squares = 0.0;
+
+    for (size_t i = 0; i < 5; ++i) {
+        double score = i / 4.0;
+        pairs += tournament->pair_scores[i];
+        sum += tournament->pair_scores[i] * score;
+        sum_of_squares += tournament->pair_scores[i] * score * score;
+    }
+
+    *mean = pairs == 0 ? 0.5 : sum / pairs;
+    *variance = pairs == 0 ? 0.0 : sum_of_squares / pairs - *mean * *mean;
+    return pairs;
+}
+
+/*******************************************************************
+Updates the log-likelihood ratio with the normal approximation of
+the generalized SPRT and decides once it leaves the bounds. The
+variance of the first few pairs means little, so the test waits for
+TOURNAMENT_MIN_PAIRS of them and puts a floor under the variance.
+*******************************************************************/
+static void tournament_t_update_sprt(tournament_t* tournament)
+{
+    double mean, variance;
+    size_t pairs = tournament_t_get_score(tournament, &mean, &variance);
+    double s0 = elo_to_score(tournament->elo0);
+    double s1 = elo_to_score(tournament->elo1);
+
+    variance = MAX(variance, TOURNAMENT_MIN_VARIANCE);
+    tournament->llr = pairs * (s1 - s0) * (2.0 * mean - s0 - s1) 
+                    / (2.0 * variance);
+
+    if (pairs < TOURNAMENT_MIN_PAIRS) {
+        return;
+    }
+
+    if (tournament->llr <= tournament->lower_bound) {
+        tournament->decision = SPRT_ACCEPT_H0;
+    } else if (tournament->llr >= tournament->upper_bound) {
+        tournament->decision = SPRT_ACCEPT_H1;
+    }
+}
+
+/*******************************************************************
+Prints the Elo difference of A over B with its 95% interval.
+*******************************************************************/
+static void tournament_t_print_elo(const tournament_t* tournament)
+{
+    double mean, variance;
+    size_t pairs = tournament_t_get_score(tournament, &mean, &variance);
+    double margin = pairs == 0 ? 0.0 : 1.96 * sqrt(variance / pairs);
+
+    printf("Elo %+.1f [%+.1f, %+.1f]", 
+           score_to_elo(mean),
+           score_to_elo(mean - margin),
+           score_to_elo(mean + margin));
+}
+
+/********************************************************
+Prints a line on the progress. Expects the mutex held.
+********************************************************/
+static void tournament_t_print_status(const tournament_t* tournament)
+{
+    printf("Games %zu: +%zu =%zu -%zu, ",
+           tournament->wins + tournament->draws + tournament->losses,
+           tournament->wins,
+           tournament->draws,
+           tournament->losses);
+    tournament_t_print_elo(tournament);
+    printf(", LLR %.2f (%.2f, %.2f)\n",
+           tournament->llr,
+           tournament->lower_bound,
+           tournament->upper_bound);
+    fflush(stdout);
+}
+
+/*******************************************************************
+Plays random movements from the empty board until 'opening_plies'
+have been made without ending the game, storing them to 'cells'.
+Returns false if out of memory or if no opening that long could be
+found.
+*******************************************************************/
+static bool tournament_t_generate_opening(const tournament_t* tournament,
+                                            uint64_t* random_state,
+                                            size_t* cells)
+{
+    const game_variant_t* variant = tournament->variant;
+    size_t movements[TOURNAMENT_MAX_CELLS];
+
+    for (size_t attempt = 0; 
+         attempt < TOURNAMENT_MAX_OPENING_ATTEMPTS; 
+         ++attempt) {
+        void* game = variant->create_game(&tournament->settings[0]);
+        PlayerColor player_color = PLAYER_X;
+        size_t ply = 0;
+
+        if (game == NULL) {
+            return false;
+        }
+
+        for (; ply < tournament->opening_plies; ++ply) {
+            size_t count = variant->list_movements(game, movements);
+
+            if (count == 0 || variant->get_winner_status(game) != WIN_NA) {
+                break;
+            }
+
+            cells[ply] = movements[split_mix_64(random_state) % count];
+            variant->make_movement(game, cells[ply], player_color);
+            player_color = invert_player_color(player_color);
+        }
+
+        bool playable = ply == tournament->opening_plies &&
+                        variant->get_winner_status(game) == WIN_NA;
+        variant->free_game(game);
+
+        if (playable) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************
+Plays a game from the opening 'cells' where 'x_engine' (0 for A, 1
+for B) moves first. Each engine searches its own copy of the game,
+so its tables never see the other engine's searches. Returns false
+if out of memory.
+*******************************************************************/
+static bool tournament_t_play_game(const tournament_t* tournament,
+                                   const size_t* cells,
+                                   size_t opening_length,
+                                   size_t x_engine,
+                                   tournament_game_t* record,
+                                   engine_statistics_t statistics[2])
+{
+    const game_variant_t* variant = tournament->variant;
+    void* games[2];
+    PlayerColor player_color = PLAYER_X;
+
+    games[0] = variant->create_game(&tournament->settings[0]);
+    games[1] = variant->create_game(&tournament->settings[1]);
+
+    if (games[0] == NULL || games[1] == NULL) {
+        if (games[0] != NULL) {
+            variant->free_game(games[0]);
+        }
+
+        if (games[1] != NULL) {
+            variant->free_game(games[1]);
+        }
+
+        return false;
+    }
+
+    record->number_of_moves = 0;
+
+    for (size_t i = 0; i < opening_length; ++i) {
+        variant->make_movement(games[0], cells[i], player_color);
+        variant->make_movement(games[1], cells[i], player_color);
+        record->cells[i] = cells[i];
+        record->has_score[i] = false;
+        record->times[i] = 0;
+        record->number_of_moves++;
+        player_color = invert_player_color(player_color);
+    }
+
+    while ((record->result = variant->get_winner_status(games[0])) 
+           == WIN_NA) {
+        size_t engine = player_color == PLAYER_X ? x_engine : 1 - x_engine;
+        search_context_t context = { 0 };
+        int score;
+        uint64_t start = micros();
+        size_t cell = variant->compute_ai_movement(games[engine],
+                                                   player_color,
+                                                   &context,
+                                                   &score);
+        uint64_t search_micros = micros() - start;
+        size_t i = record->number_of_moves++;
+
+        variant->make_movement(games[0], cell, player_color);
+        variant->make_movement(games[1], cell, player_color);
+        record->cells[i] = cell;
+        record->has_score[i] = true;
+        record->scores[i] = score;
+        record->times[i] = (size_t)(search_micros / 1000);
+
+        statistics[engine].nodes += context.nodes;
+        statistics[engine].search_micros += search_micros;
+        statistics[engine].max_move_micros = 
+            MAX(statistics[engine].max_move_micros, search_micros);
+        statistics[engine].moves++;
+        player_color = invert_player_color(player_color);
+    }
+
+    variant->free_game(games[0]);
+    variant->free_game(games[1]);
+    return true;
+}
+
+/*******************************************************
+Appends a finished game to the record. Expects the mutex
+held, since the writer buffers one game at a time.
+*******************************************************/
+static void tournament_t_record_game(tournament_t* tournament,
+                                     const tournament_game_t* game)
+{
+    game_record_writer_t* writer = tournament->record_writer;
+    game_record_writer_t_begin_game(writer, PLAYER_X);
+
+    for (size_t i = 0; i < game->number_of_moves; ++i) {
+        game_record_writer_t_add_move(writer,
+                                      game->cells[i],
+                                      game->has_score[i],
+                                      game->scores[i],
+                                      game->times[i]);
+    }
+
+    game_record_writer_t_end_game(writer, game->result);
+}
+
+/*******************************************************************
+Plays pairs of games until the test decides or the pairs run out.
+The pairs that finish after the decision are not counted.
+*******************************************************************/
+static void tournament_routine(void* argument)
+{
+    tournament_t* tournament = argument;
+    size_t cells[TOURNAMENT_MAX_CELLS];
+    tournament_game_t records[2];
+
+    while (true) {
+        engine_statistics_t statistics[2] = { 0 };
+        size_t half_points = 0;
+        bool played;
+
+        mutex_t_lock(&tournament->mutex);
+
+        if (tournament->decision != SPRT_CONTINUE ||
+            tournament->failed ||
+            tournament->next_pair == tournament->max_pairs) {
+            mutex_t_unlock(&tournament->mutex);
+            return;
+        }
+
+        uint64_t random_state = tournament->seed + tournament->next_pair++;
+        mutex_t_unlock(&tournament->mutex);
+
+        played = tournament_t_generate_opening(tournament,
+                                               &random_state,
+                                               cells);
+
+        // A plays X in the first game and O in the second one.
+        for (size_t x_engine = 0; x_engine < 2 && played; ++x_engine) {
+            played = tournament_t_play_game(tournament,
+                                            cells,
+                                            tournament->opening_plies,
+                                            x_engine,
+                                            &records[x_engine],
+                                            statistics);
+        }
+
+        mutex_t_lock(&tournament->mutex);
+
+        if (!played) {
+            tournament->failed = true;
+            mutex_t_unlock(&tournament->mutex);
+            return;
+        }
+
+        // A pair still being played when the test decided is dropped,
+        // so that the counts reported match the LLR that decided.
+        if (tournament->decision != SPRT_CONTINUE) {
+            mutex_t_unlock(&tournament->mutex);
+            return;
+        }
+
+        for (size_t x_engine = 0; x_engine < 2; ++x_engine) {
+            WinningStatus result = records[x_engine].result;
+            WinningStatus a_wins = x_engine == 0 ? WIN_X : WIN_O;
+
+            if (result == WIN_TIE) {
+                tournament->draws++;
+                half_points += 1;
+            } else if (result == a_wins) {
+                tournament->wins++;
+                half_points += 2;
+            } else {
+                tournament->losses++;
+            }
+
+            if (tournament->record_writer != NULL) {
+                tournament_t_record_game(tournament, &records[x_engine]);
+            }
+        }
+
+        for (size_t engine = 0; engine < 2; ++engine) {
+            engine_statistics_t* total = &tournament->statistics[engine];
+            total->nodes += statistics[engine].nodes;
+            total->search_micros += statistics[engine].search_micros;
+            total->max_move_micros = MAX(total->max_move_micros,
+                                         statistics[engine].max_move_micros);
+            total->moves += statistics[engine].moves;
+        }
+
+        tournament->pair_scores[half_points]++;
+        tournament_t_update_sprt(tournament);
+
+        uint64_t now = micros();
+
+        if (now - tournament->last_status_micros >= TOURNAMENT_STATUS_MICROS) {
+            tournament->last_status_micros = now;
+            tournament_t_print_status(tournament);
+        }
+
+        mutex_t_unlock(&tournament->mutex);
+    }
+}
+
+/*******************************************************************
+Prints the outcome of the tournament and what each engine spent.
+*******************************************************************/
+static void tournament_t_print_report(const tournament_t* tournament)
+{
+    static const char* const NAMES[2] = { "A", "B" };
+
+    printf("Played in %.1f seconds.\n",
+           (micros() - tournament->start_micros) / 1e6);
+    tournament_t_print_status(tournament);
+
+    switch (tournament->decision) {
+    case SPRT_ACCEPT_H0:
+        printf("SPRT: H0 accepted, A is closer to %+.1f than to %+.1f Elo.\n",
+               tournament->elo0,
+               tournament->elo1);
+        break;
+
+    case SPRT_ACCEPT_H1:
+        printf("SPRT: H1 accepted, A is closer to %+.1f than to %+.1f Elo.\n",
+               tournament->elo1,
+               tournament->elo0);
+        break;
+
+    default:
+        puts("SPRT: undecided.");
+        break;
+    }
+
+    for (size_t engine = 0; engine < 2; ++engine) {
+        const engine_statistics_t* statistics = 
+            &tournament->statistics[engine];
+        size_t moves = MAX(statistics->moves, 1);
+        uint64_t search_micros = MAX(statistics->search_micros, 1);
+
+        printf("Engine %s: %.0f nodes/s, %.2f ms per move (%.2f ms at most)"
+               ", %zu moves.\n",
+               NAMES[engine],
+               statistics->nodes * 1e6 / search_micros,
+               statistics->search_micros / 1000.0 / moves,
+               statistics->max_move_micros / 1000.0,
+               statistics->moves);
+    }
+}
+
+/*******************************************************************
+Runs the tournament on 'number_of_threads' threads. Returns false if
+no thread could be started or a pair could not be played.
+*******************************************************************/
+static bool tournament_t_run(tournament_t* tournament,
+                             size_t number_of_threads)
+{
+    thread_t* threads = malloc(sizeof(thread_t) * number_of_threads);
+    size_t number_of_started_threads = 0;
+
+    if (threads == NULL) {
+        return false;
+    }
+
+    tournament->lower_bound = 
+        log(TOURNAMENT_ERROR_RATE / (1.0 - TOURNAMENT_ERROR_RATE));
+    tournament->upper_bound = 
+        log((1.0 - TOURNAMENT_ERROR_RATE) / TOURNAMENT_ERROR_RATE);
+    tournament->start_micros = micros();
+    tournament->last_status_micros = tournament->start_micros;
+    mutex_t_init(&tournament->mutex);
+
+    while (number_of_started_threads < number_of_threads &&
+           thread_t_start(&threads[number_of_started_threads],
+                          tournament_routine,
+                          tournament)) {
+        number_of_started_threads++;
+    }
+
+    for (size_t i = 0; i < number_of_started_threads; ++i) {
+        thread_t_join(&threads[i]);
+    }
+
+    mutex_t_free(&tournament->mutex);
+    free(threads);
+    return number_of_started_threads > 0 && !tournament->failed;
+}
+
+/***************************************************************
+Parses a positive count from a command line argument. Returns 0
+if the argument is not a positive integer.
+***************************************************************/
+static size_t parse_count_argument(const wchar_t* argument)
+{
+    wchar_t* end;
+    unsigned long count = wcstoul(argument, &end, 10);
+    return *end == L'\0' ? (size_t)count : 0;
+}
+
+/*******************************
+Prints the command line usage.
+*******************************/
+static void print_usage()
+{
+    puts("Usage:");
+    puts("  tictactoe [--variant NAME]     Play against the AI; NAME is");
+    puts("            [--time MS]          3x3 (default), qubic (4x4x4) or");
+    puts("            [--record FILE]      ultimate. MS limits the time per");
+    puts("                                 qubic or ultimate AI move and");
+    puts("                                 FILE gets the game appended.");
+    puts("  tictactoe --analyze [FILE]     Analyze the positions in FILE");
+    puts("            [--threads N]        (or the standard input), one");
+    puts("            [--capacity N]       per line.");
+    puts("            [--lines L]          Rank the L best movements with");
+    puts("                                 their principal variations.");
+    puts("  tictactoe --replay FILE        Summarize the recorded games in");
+    puts("            [--games]            FILE, listing them if asked.");
+    puts("  tictactoe --solve WxH K        Solve K in a row on a WxH board");
+    puts("            [--depth D]          (at most 64 cells), split at");
+    puts("            [--workers N]        depth D into units for N local");
+    puts("            [--listen ADDRESS]   worker processes and any remote");
+    puts("            [--port PORT]        ones. FILE keeps the results to");
+    puts("            [--checkpoint FILE]  resume from; a unit held longer");
+    puts("            [--lease SECONDS]    than the lease goes to another");
+    puts("            [--exact]            worker. --exact finds how long");
+    puts("                                 the win takes, too.");
+    puts("  tictactoe --work HOST:PORT     Solve units for the --solve at");
+    puts("                                 HOST:PORT.");
+    puts("  tictactoe --tournament         Play engine A against engine B");
+    puts("            [--variant NAME]     in pairs of games from random");
+    puts("            [--engine-a SET]     openings of PLIES movements,");
+    puts("            [--engine-b SET]     swapping the colors, until a");
+    puts("            [--games N]          sequential test decides between");
+    puts("            [--threads N]        A gaining E0 (default 0) and E1");
+    puts("            [--openings PLIES]   (default 10) Elo over B. SET is");
+    puts("            [--elo0 E0]          a comma separated list of");
+    puts("            [--elo1 E1]          time=MS, depth=N, table=BITS");
+    puts("            [--seed S]           and history=on|off for qubic");
+    puts("            [--record FILE]      and ultimate, or");
+    puts("                                 preferences=CORNER/EDGE/CENTER");
+    puts("                                 for 3x3, whose search always");
+    puts("                                 runs to the end.");
+    puts("");
+    puts("Playing and --analyze also accept --telemetry FILE, writing a");
+    puts("JSON line per search, and --trace FILE, writing a Chrome trace.");
+}
+
+/*******************************************************************
+The --telemetry FILE and --trace FILE options of the commands that
+run searches.
+*******************************************************************/
+typedef struct telemetry_options_t
+{
+    const wchar_t* telemetry_path;
+    const wchar_t* trace_path;
+    FILE* telemetry_file;         // NULL unless writing telemetry.
+    trace_writer_t* trace_writer; // NULL unless tracing.
+    trace_writer_t trace_writer_storage;
+} telemetry_options_t;
+
+/*******************************************************************
+Consumes the telemetry option at 'argv[*i]', if any, along with its
+value. Returns false if 'argv[*i]' is no telemetry option.
+*******************************************************************/
+static bool telemetry_options_t_parse(telemetry_options_t* options,
+                                      int argc,
+                                      wchar_t* argv[],
+                                      int* i)
+{
+    if (*i + 1 >= argc) {
+        return false;
+    }
+
+    if (wcscmp(argv[*i], L"--telemetry") == 0) {
+        options->telemetry_path = argv[++*i];
+        return true;
+    }
+
+    if (wcscmp(argv[*i], L"--trace") == 0) {
+        options->trace_path = argv[++*i];
+        return true;
+    }
+
+    return false;
+}
+
+/*******************************************************************
+Opens the telemetry and the trace files asked for. Returns false,
+having reported why, if any of them cannot be opened.
+*******************************************************************/
+static bool telemetry_options_t_open(telemetry_options_t* options)
+{
+    options->telemetry_file = NULL;
+    options->trace_writer = NULL;
+
+#if SEARCH_TELEMETRY
+    if (options->telemetry_path != NULL) {
+        options->telemetry_file = open_file(options->telemetry_path, "w");
+
+        if (options->telemetry_file == NULL) {
+            fprintf(stderr, "Could not open %ls.\n", options->telemetry_path);
+            return false;
+        }
+    }
+
+    if (options->trace_path != NULL) {
+        if (!trace_writer_t_open(&options->trace_writer_storage, 
+                                 options->trace_path)) {
+            fprintf(stderr, "Could not open %ls.\n", options->trace_path);
+
+            if (options->telemetry_file != NULL) {
+                fclose(options->telemetry_file);
+            }
+
+            return false;
+        }
+
+        options->trace_writer = &options->trace_writer_storage;
+    }
+
+    return true;
+#else
+    if (options->telemetry_path != NULL || options->trace_path != NULL) {
+        fputs("Compiled without the search telemetry.\n", stderr);
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+/****************************************************
+Closes the telemetry and the trace files, if open.
+****************************************************/
+static void telemetry_options_t_close(telemetry_options_t* options)
+{
+#if SEARCH_TELEMETRY
+    if (options->telemetry_file != NULL) {
+        fclose(options->telemetry_file);
+    }
+
+    if (options->trace_writer != NULL) {
+        trace_writer_t_close(options->trace_writer);
+    }
+#else
+    (void)options;
+#endif
+}
+
+/*****************************************************************
+Runs the batch analysis: tictactoe --analyze [FILE] [--threads N]
+[--capacity N] [--lines L] [--telemetry FILE] [--trace FILE].
+*****************************************************************/
+static int analysis_command(int argc, wchar_t* argv[])
+{
+    telemetry_options_t telemetry_options = { 0 };
+    const wchar_t* input_path = NULL;
+    size_t number_of_solvers = get_number_of_processors();
+    size_t capacity = ANALYSIS_DEFAULT_CAPACITY;
+    size_t number_of_lines = 0;
+    bool lines_asked = false;
+
+    for (int i = 2; i < argc; ++i) {
+        if (wcscmp(argv[i], L"--threads") == 0 && i + 1 < argc) {
+            number_of_solvers = parse_count_argument(argv[++i]);
+        } else if (wcscmp(argv[i], L"--capacity") == 0 && i + 1 < argc) {
+            capacity = parse_count_argument(argv[++i]);
+        } else if (wcscmp(argv[i], L"--lines") == 0 && i + 1 < argc) {
+            number_of_lines = parse_count_argument(argv[++i]);
+            lines_asked = true;
+        } else if (telemetry_options_t_parse(&telemetry_options, 
+                                             argc, 
+                                             argv, 
+                                             &i)) {
+            continue;
+        } else if (input_path == NULL && argv[i][0] != L'-') {
+            input_path = argv[i];
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (number_of_solvers == 0 || 
+        capacity == 0 || 
+        (lines_asked && number_of_lines == 0)) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    FILE* input = input_path == NULL ? stdin : open_file(input_path, "r");
+
+    if (input == NULL) {
+        fprintf(stderr, "Could not open %ls.\n", input_path);
+        return EXIT_FAILURE;
+    }
+
+    if (!telemetry_options_t_open(&telemetry_options)) {
+        if (input != stdin) {
+            fclose(input);
+        }
+
+        return EXIT_FAILURE;
+    }
+
+#if SEARCH_TELEMETRY
+    if (telemetry_options.trace_writer != NULL) {
+        trace_writer_t_name_thread(telemetry_options.trace_writer,
+                                   ANALYSIS_WRITER_THREAD_ID,
+                                   "writer");
+        trace_writer_t_name_thread(telemetry_options.trace_writer,
+                                   ANALYSIS_PARSER_THREAD_ID,
+                                   "parser");
+
+        for (size_t i = 0; i < number_of_solvers; ++i) {
+            trace_writer_t_name_thread(telemetry_options.trace_writer,
+                                       ANALYSIS_FIRST_SOLVER_THREAD_ID + i,
+                                       "solver");
+        }
+    }
+#endif
+
+    bool success = analyze_positions(input, 
+                                     stdout, 
+                                     number_of_solvers, 
+                                     capacity,
+                                     number_of_lines,
+                                     telemetry_options.telemetry_file,
+                                     telemetry_options.trace_writer);
+    telemetry_options_t_close(&telemetry_options);
+
+    if (input != stdin) {
+        fclose(input);
+    }
+
+    if (!success) {
+        fputs("Could not start the analysis threads.\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*******************************************************************
+Runs the coordinator of a distributed solve: tictactoe --solve WxH K
+[--depth D] [--workers N] [--listen ADDRESS] [--port PORT] 
+[--checkpoint FILE] [--lease SECONDS] [--exact].
+*******************************************************************/
+static int solve_command(int argc, wchar_t* argv[])
+{
+    coordinator_t coordinator = { 0 };
+    worker_pool_t pool = { 0 };
+    mnk_rules_t rules;
+    const wchar_t* checkpoint_path = NULL;
+    char listen_address[256] = "127.0.0.1";
+    char local_address[300];
+    char program[1024] = "tictactoe";
+    unsigned width, height;
+    wchar_t trailing;
+    size_t k = argc > 3 ? parse_count_argument(argv[3]) : 0;
+    size_t split_depth = SOLVER_DEFAULT_SPLIT_DEPTH;
+    size_t number_of_workers = get_number_of_processors();
+    size_t port = 0;
+    size_t lease_seconds = 0;
+    bool exact = false;
+
+    if (k == 0 || 
+        swscanf(argv[2], L"%ux%u%lc", &width, &height, &trailing) != 2) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 4; i < argc; ++i) {
+        if (wcscmp(argv[i], L"--depth") == 0 && i + 1 < argc) {
+            split_depth = parse_count_argument(argv[++i]);
+        } else if (wcscmp(argv[i], L"--workers") == 0 && i + 1 < argc) {
+            number_of_workers = wcscmp(argv[++i], L"0") == 0 
+                ? 0 
+                : parse_count_argument(argv[i]);
+
+            if (number_of_workers == 0 && wcscmp(argv[i], L"0") != 0) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--listen") == 0 && i + 1 < argc) {
+            if (wcstombs(listen_address, argv[++i], sizeof(listen_address)) 
+                    >= sizeof(listen_address)) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--port") == 0 && i + 1 < argc) {
+            port = parse_count_argument(argv[++i]);
+
+            if (port == 0 || port > UINT16_MAX) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (wcscmp(argv[i], L"--lease") == 0 && i + 1 < argc) {
+            lease_seconds = parse_count_argument(argv[++i]);
+
+            if (lease_seconds == 0) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--exact") == 0) {
+            exact = true;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (split_depth == 0) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    if (!mnk_rules_t_init(&rules, width, height, k)) {
+        fputs("The board may have at most 8 rows and 8 columns, and K may "
+              "not exceed the longer side.\n", 
+              stderr);
+        return EXIT_FAILURE;
+    }
+
+    if (wcstombs(program, argv[0], sizeof(program)) >= sizeof(program)) {
+        strcpy(program, "tictactoe");
+    }
+
+    uint64_t start = micros();
+
+    coordinator.rules = &rules;
+    coordinator.split_depth = MIN(split_depth, width * height);
+    coordinator.alpha = exact ? -SEARCH_WIN_SCORE : -1;
+    coordinator.beta = exact ? SEARCH_WIN_SCORE : 1;
+
+    if (!coordinator_t_split(&coordinator)) {
+        fputs("The split tree does not fit in memory.\n", stderr);
+        coordinator_t_free(&coordinator);
+        mnk_rules_t_free(&rules);
+        return EXIT_FAILURE;
+    }
+
+    if (checkpoint_path != NULL &&
+        !coordinator_t_open_checkpoint(&coordinator, checkpoint_path)) {
+        coordinator_t_free(&coordinator);
+        mnk_rules_t_free(&rules);
+        return EXIT_FAILURE;
+    }
+
+    printf("Board: %ux%u, %zu in a row, split at depth %zu into %zu units.\n",
+           width,
+           height,
+           k,
+           coordinator.split_depth,
+           coordinator.number_of_units);
+
+    uint16_t listen_port = (uint16_t)port;
+    socket_t listener = sockets_init() 
+        ? socket_t_listen(listen_address, &listen_port) 
+        : INVALID_SOCKET;
+
+    if (listener == INVALID_SOCKET) {
+        fprintf(stderr, "Could not listen on %s.\n", listen_address);
+        coordinator_t_free(&coordinator);
+        mnk_rules_t_free(&rules);
+        return EXIT_FAILURE;
+    }
+
+    printf("Listening on %s port %u.\n", listen_address, listen_port);
+    fflush(stdout);
+
+    // Local workers reach a wildcard address over the loopback.
+    const char* local_host = 
+        strcmp(listen_address, "0.0.0.0") == 0 ? "127.0.0.1" :
+        strcmp(listen_address, "::") == 0 ? "::1" : listen_address;
+
+    snprintf(local_address,
+             sizeof(local_address),
+             strchr(local_host, ':') != NULL ? "[%s]:%u" : "%s:%u",
+             local_host,
+             listen_port);
+    pool.program = program;
+    pool.address = local_address;
+    pool.processes = calloc(MAX(number_of_workers, 1), sizeof(process_t));
+
+    if (!coordinator_t_is_settled(&coordinator, 0)) {
+        for (size_t i = 0; 
+             i < number_of_workers && pool.processes != NULL; 
+             ++i) {
+            if (!worker_pool_t_start(&pool, 
+                                     &pool.processes[pool.number_of_processes])) {
+                fputs("Could not start a local worker.\n", stderr);
+                break;
+            }
+
+            pool.number_of_processes++;
+        }
+    }
+
+    pool.restarts_left = 
+        SOLVER_MAX_RESTARTS_PER_WORKER * pool.number_of_processes;
+
+    bool settled = coordinator_t_run(&coordinator, 
+                                     listener, 
+                                     &pool, 
+                                     (uint64_t)lease_seconds * 1000 * 1000);
+    uint64_t duration = micros() - start;
+
+    worker_pool_t_dismiss(&pool, listener);
+    socket_t_close(listener);
+
+    print_solve_result(coordinator.nodes[0].lower, coordinator.nodes[0].upper);
+    printf("Units: %zu solved, %zu restored from the checkpoint, "
+           "%zu not needed.\n",
+           coordinator.units_done,
+           coordinator.units_restored,
+           coordinator.number_of_units - coordinator.units_done - 
+               coordinator.units_restored);
+    printf("Nodes: %llu.\n", (unsigned long long)coordinator.nodes_searched);
+    printf("Duration: %llu milliseconds.\n",
+           (unsigned long long)(duration / 1000));
+
+    free(pool.processes);
+    coordinator_t_free(&coordinator);
+    mnk_rules_t_free(&rules);
+    sockets_free();
+
+    if (!settled) {
+        fputs("The units ran out before the result was settled.\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*******************************************************************
+Runs a worker of a distributed solve: tictactoe --work HOST:PORT, 
+HOST being in brackets if an IPv6 address.
+*******************************************************************/
+static int work_command(int argc, wchar_t* argv[])
+{
+    char address[300];
+
+    if (argc != 3 || 
+        wcstombs(address, argv[2], sizeof(address)) >= sizeof(address)) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    char* host = address;
+    char* separator = strrchr(address, ':');
+
+    if (separator == NULL || separator == address) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    *separator = '\0';
+
+    if (host[0] == '[' && separator[-1] == ']') {
+        host++;
+        separator[-1] = '\0';
+    }
+
+    if (!sockets_init()) {
+        fputs("Could not initialize the sockets.\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    bool success = run_worker(host, separator + 1);
+    sockets_free();
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*******************************************************************
+Parses the engine settings of a tournament, a comma separated list
+of time=MS, depth=N, table=BITS and history=on|off for the Qubic and
+Ultimate engines, or preferences=CORNER/EDGE/CENTER for the 3x3 one.
+Returns false, having reported why, on anything else, including the
+settings the engine of 'variant' would ignore.
+*******************************************************************/
+static bool engine_settings_t_parse(engine_settings_t* settings,
+                                    const game_variant_t* variant,
+                                    const wchar_t* text)
+{
+    while (*text != L'\0') {
+        wchar_t* end = (wchar_t*)text;
+        uint8_t setting;
+        bool valid = true;
+
+        if (wcsncmp(text, L"time=", 5) == 0) {
+            setting = ENGINE_SETTING_TIME;
+            settings->time_budget = (uint32_t)wcstoul(text + 5, &end, 10);
+            valid = end != text + 5 && settings->time_budget != 0;
+        } else if (wcsncmp(text, L"depth=", 6) == 0) {
+            setting = ENGINE_SETTING_DEPTH;
+            settings->max_depth = (uint32_t)wcstoul(text + 6, &end, 10);
+            valid = end != text + 6 && settings->max_depth != 0;
+        } else if (wcsncmp(text, L"table=", 6) == 0) {
+            setting = ENGINE_SETTING_TABLE;
+            settings->table_bits = (uint32_t)wcstoul(text + 6, &end, 10);
+            valid = end != text + 6 && 
+                    settings->table_bits >= 10 && 
+                    settings->table_bits <= 28;
+        } else if (wcsncmp(text, L"history=off", 11) == 0) {
+            setting = ENGINE_SETTING_HISTORY;
+            settings->no_history = true;
+            end += 11;
+        } else if (wcsncmp(text, L"history=on", 10) == 0) {
+            setting = ENGINE_SETTING_HISTORY;
+            settings->no_history = false;
+            end += 10;
+        } else if (wcsncmp(text, L"preferences=", 12) == 0) {
+            long weights[3];
+            setting = ENGINE_SETTING_PREFERENCES;
+            end += 12;
+
+            for (size_t i = 0; i < 3 && valid; ++i) {
+                const wchar_t* start = end;
+                weights[i] = wcstol(start, &end, 10);
+                valid = end != start && (i == 2 || *end++ == L'/');
+            }
+
+            for (size_t y = 0; y < HEIGHT && valid; ++y) {
+                for (size_t x = 0; x < WIDTH; ++x) {
+                    size_t edges = (x != 1) + (y != 1);
+                    // 2 for the corners, 1 for the edges, 0 for the center.
+                    settings->preference_filter[y][x] = 
+                        (int)weights[edges == 2 ? 0 : edges == 1 ? 1 : 2];
+                }
+            }
+
+            settings->has_preference_filter = true;
+        } else {
+            fprintf(stderr, "Unknown engine setting: %ls\n", text);
+            return false;
+        }
+
+        if (!valid || (*end != L',' && *end != L'\0')) {
+            fprintf(stderr, "Invalid engine setting: %ls\n", text);
+            return false;
+        }
+
+        if ((variant->engine_settings & setting) == 0) {
+            fprintf(stderr, 
+                    "The %s engine ignores %.*ls.\n", 
+                    variant->name, 
+                    (int)(end - text), 
+                    text);
+            return false;
+        }
+
+        text = *end == L',' ? end + 1 : end;
+    }
+
+    return true;
+}
+
+/*******************************************************************
+Runs an engine tournament: tictactoe --tournament [--variant NAME]
+[--engine-a SETTINGS] [--engine-b SETTINGS] [--games N] 
+[--threads N] [--openings PLIES] [--elo0 E] [--elo1 E] [--seed S]
+[--record FILE].
+*******************************************************************/
+static int tournament_command(int argc, wchar_t* argv[])
+{
+    tournament_t tournament = { 0 };
+    game_record_writer_t record_writer;
+    const wchar_t* record_path = NULL;
+    size_t number_of_threads = get_number_of_processors();
+    size_t number_of_games = 2 * TOURNAMENT_DEFAULT_PAIRS;
+    const wchar_t* settings_texts[2] = { L"", L"" };
+    bool has_seed = false;
+
+    tournament.variant = &CLASSIC_VARIANT;
+    tournament.opening_plies = TOURNAMENT_DEFAULT_OPENING_PLIES;
+    tournament.elo1 = TOURNAMENT_DEFAULT_ELO1;
+
+    for (int i = 2; i < argc; ++i) {
+        wchar_t* end;
+
+        if (i + 1 == argc) {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+
+        if (wcscmp(argv[i], L"--variant") == 0) {
+            tournament.variant = find_game_variant(argv[++i]);
+
+            if (tournament.variant == NULL) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--engine-a") == 0 ||
+                   wcscmp(argv[i], L"--engine-b") == 0) {
+            // Parsed once the variant is known.
+            size_t engine = argv[i][9] == L'a' ? 0 : 1;
+            settings_texts[engine] = argv[++i];
+        } else if (wcscmp(argv[i], L"--games") == 0) {
+            number_of_games = parse_count_argument(argv[++i]);
+        } else if (wcscmp(argv[i], L"--threads") == 0) {
+            number_of_threads = parse_count_argument(argv[++i]);
+        } else if (wcscmp(argv[i], L"--openings") == 0) {
+            tournament.opening_plies = wcstoul(argv[++i], &end, 10);
+
+            if (*end != L'\0') {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--elo0") == 0 || 
+                   wcscmp(argv[i], L"--elo1") == 0) {
+            double* elo = argv[i][5] == L'0' ? &tournament.elo0 
+                                             : &tournament.elo1;
+            *elo = wcstod(argv[++i], &end);
+
+            if (*end != L'\0') {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--seed") == 0) {
+            tournament.seed = wcstoull(argv[++i], &end, 10);
+            has_seed = true;
+
+            if (*end != L'\0') {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--record") == 0) {
+            record_path = argv[++i];
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    const game_variant_t* variant = tournament.variant;
+
+    for (size_t engine = 0; engine < 2; ++engine) {
+        if (!engine_settings_t_parse(&tournament.settings[engine],
+                                     variant,
+                                     settings_texts[engine])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    size_t number_of_cells = 
+        (size_t)variant->width * variant->height * variant->layers;
+
+    if (number_of_threads == 0 || 
+        number_of_games < 2 ||
+        tournament.elo0 >= tournament.elo1 ||
+        tournament.opening_plies >= number_of_cells) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    tournament.max_pairs = number_of_games / 2;
+
+    if (!has_seed) {
+        tournament.seed = (uint64_t)time(NULL);
+    }
+
+    if (record_path != NULL) {
+        // The header has room for a single budget; 0 marks the games
+        // where the engines were given different ones.
+        uint32_t time_budget = 
+            tournament.settings[0].time_budget == 
+            tournament.settings[1].time_budget 
+                ? tournament.settings[0].time_budget 
+                : 0;
+
+        game_record_header_t header = { 
+            variant->width, 
+            variant->height, 
+            variant->layers, 
+            variant->row_length, 
+            GAME_RECORD_FLAG_SCORES | GAME_RECORD_FLAG_TIMES, 
+            0, 
+            time_budget 
+        };
+
+        RecordOpenStatus status = 
+            game_record_writer_t_open(&record_writer, record_path, &header);
+
+        if (status != RECORD_OPENED) {
+            print_record_open_error(status, record_path);
+            return EXIT_FAILURE;
+        }
+
+        tournament.record_writer = &record_writer;
+    }
+
+    load_all_sprites();
+    load_qubic_tables();
+    load_ultimate_tables();
+    printf("Playing at most %zu games on %zu threads, seed %llu.\n",
+           2 * tournament.max_pairs,
+           number_of_threads,
+           (unsigned long long)tournament.seed);
+
+    bool success = tournament_t_run(&tournament, number_of_threads);
+
+    if (tournament.record_writer != NULL &&
+        !game_record_writer_t_close(tournament.record_writer)) {
+        fputs("Could not record the games.\n", stderr);
+        success = false;
+    }
+
+    if (!success) {
+        fputs("Could not play the tournament.\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    tournament_t_print_report(&tournament);
+    return EXIT_SUCCESS;
+}
+
+/*******************************************************************
+Prints a recorded game as the first player, the result and the moves
+(cell numbers counting from 1), e.g. "X T 5 1 9 3 7 4 6 2 8".
+*******************************************************************/
+static bool print_game_record(const game_record_t* game,
+                              const game_record_header_t* header)
+{
+    uint16_t cells[GAME_RECORD_MAX_MOVES];
+
+    if (!game_record_t_decode(game, header, cells, NULL, NULL, NULL)) {
+        return false;
+    }
+
+    printf("%c %c",
+           game->first_player == PLAYER_X ? 'X' : 'O',
+           (char)game->result);
+
+    for (size_t i = 0; i < game->number_of_moves; ++i) {
+        printf(" %u", (unsigned)cells[i] + 1);
+    }
+
+    puts("");
+    return true;
+}
+
+/*****************************************************************
+Scans a game record file: tictactoe --replay FILE [--games].
+*****************************************************************/
+static int replay_command(int argc, wchar_t* argv[])
+{
+    game_record_reader_t reader;
+    game_record_t game;
+    bool list_games = argc == 4 && wcscmp(argv[3], L"--games") == 0;
+    size_t results[4] = { 0 }; // X, O, tie, unfinished.
+    size_t number_of_games = 0;
+    size_t number_of_moves = 0;
+    bool corrupt = false;
+
+    if (argc != 3 && !list_games) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    if (!game_record_reader_t_open(&reader, argv[2])) {
+        fprintf(stderr, "Could not read the game records in %ls.\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    size_t duration = millis();
+
+    while (game_record_reader_t_next(&reader, &game)) {
+        if (list_games && !print_game_record(&game, &reader.header)) {
+            corrupt = true;
+            break;
+        }
+
+        number_of_games++;
+        number_of_moves += game.number_of_moves;
+        results[game.result == WIN_X ? 0 :
+                game.result == WIN_O ? 1 :
+                game.result == WIN_TIE ? 2 : 3]++;
+    }
+
+    duration = millis() - duration;
+    corrupt = corrupt || reader.offset != reader.size;
+
+    printf("Board: %ux%ux%u, %u in a row.\n",
+           (unsigned)reader.header.width,
+           (unsigned)reader.header.height,
+           (unsigned)reader.header.layers,
+           (unsigned)reader.header.row_length);
+    printf("Games: %zu (X won %zu, O won %zu, tied %zu, unfinished %zu).\n",
+           number_of_games,
+           results[0],
+           results[1],
+           results[2],
+           results[3]);
+    printf("Moves: %zu.\n", number_of_moves);
+    printf("Scan duration: %zu milliseconds.\n", duration);
+
+    if (corrupt) {
+        fprintf(stderr, "Corrupt game at byte offset %zu.\n", reader.offset);
+    }
+
+    game_record_reader_t_close(&reader);
+    return corrupt ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/*****************************************************************
+Runs a match against the bot: tictactoe [--variant NAME] 
+[--time MS] [--record FILE] [--telemetry FILE] [--trace FILE].
+*****************************************************************/
+static int play_command(int argc, wchar_t* argv[])
+{
+    telemetry_options_t telemetry_options = { 0 };
+    play_options_t play_options = { 0 };
+    const game_variant_t* variant = &CLASSIC_VARIANT;
+    const wchar_t* record_path = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (wcscmp(argv[i], L"--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (wcscmp(argv[i], L"--variant") == 0 && i + 1 < argc) {
+            variant = find_game_variant(argv[++i]);
+
+            if (variant == NULL) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (wcscmp(argv[i], L"--time") == 0 && i + 1 < argc) {
+            play_options.engine_settings.time_budget = 
+                (uint32_t)parse_count_argument(argv[++i]);
+
+            if (play_options.engine_settings.time_budget == 0) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (!telemetry_options_t_parse(&telemetry_options,
+                                              argc,
+                                              argv,
+                                              &i)) {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (play_options.engine_settings.time_budget != 0 &&
+        (variant->engine_settings & ENGINE_SETTING_TIME) == 0) {
+        fprintf(stderr, "The %s engine ignores --time.\n", variant->name);
+        return EXIT_FAILURE;
+    }
+
+    if (record_path != NULL) {
+        game_record_header_t header = { 
+            variant->width, 
+            variant->height, 
+            variant->layers, 
+            variant->row_length, 
+            GAME_RECORD_FLAG_SCORES | GAME_RECORD_FLAG_TIMES, 
+            0, 
+            play_options.engine_settings.time_budget 
+        };
+
+        RecordOpenStatus status = RECORD_UNWRITABLE;
+
+        play_options.record_writer = 
+            malloc(sizeof(*play_options.record_writer));
+
+        if (play_options.record_writer != NULL) {
+            status = game_record_writer_t_open(play_options.record_writer, 
+                                               record_path, 
+                                               &header);
+        }
+
+        if (status != RECORD_OPENED) {
+            print_record_open_error(status, record_path);
+            free(play_options.record_writer);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!telemetry_options_t_open(&telemetry_options)) {
+        if (play_options.record_writer != NULL) {
+            game_record_writer_t_close(play_options.record_writer);
+            free(play_options.record_writer);
+        }
+
+        return EXIT_FAILURE;
+    }
+
+    play_options.telemetry_file = telemetry_options.telemetry_file;
+    play_options.trace_writer = telemetry_options.trace_writer;
+
+    // v
+    // v
+    // v For random choice whether X or O makes the first move.
+    srand(time(NULL)); 
+    load_all_sprites();
+    load_qubic_tables();
+    load_ultimate_tables();
+    bot_mode(variant, &play_options);
+    telemetry_options_t_close(&telemetry_options);
+
+    if (play_options.record_writer != NULL) {
+        bool recorded = game_record_writer_t_close(play_options.record_writer);
+        free(play_options.record_writer);
+
+        if (!recorded) {
+            fputs("Could not record the game.\n", stderr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return 0;
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+    if (argc > 1 && wcscmp(argv[1], L"--analyze") == 0) {
+        return analysis_command(argc, argv);
+    } else if (argc > 1 && wcscmp(argv[1], L"--replay") == 0) {
+        return replay_command(argc, argv);
+    } else if (argc > 2 && wcscmp(argv[1], L"--solve") == 0) {
+        return solve_command(argc, argv);
+    } else if (argc > 1 && wcscmp(argv[1], L"--work") == 0) {
+        return work_command(argc, argv);
+    } else if (argc > 1 && wcscmp(argv[1], L"--tournament") == 0) {
+        return tournament_command(argc, argv);
+    }
+
+    return play_command(argc, argv);
+}
+
+#ifndef _WIN32
+/************************************************************
+Widens the command line arguments and passes them to wmain().
+************************************************************/
+int main(int argc, char* argv[])
+{
+    wchar_t** wide_argv = malloc(sizeof(wchar_t*) * (argc + 1));
+
+    for (int i = 0; i < argc; ++i) {
+        size_t length = mbstowcs(NULL, argv[i], 0);
+        length = length == (size_t)-1 ? 0 : length;
+        wide_argv[i] = calloc(length + 1, sizeof(wchar_t));
+        mbstowcs(wide_argv[i], argv[i], length + 1);
+    }
+
+    wide_argv[argc] = NULL;
+
+    int exit_status = wmain(argc, wide_argv);
+
+    for (int i = 0; i < argc; ++i) {
+        free(wide_argv[i]);
+    }
+
+    free(wide_argv);
+    return exit_status;
 }
+#endif // _WIN32